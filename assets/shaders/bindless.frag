@@ -0,0 +1,30 @@
+#version 400 core
+#extension GL_ARB_bindless_texture : require
+// the batched draws look the handles up per instance; ARB_bindless_texture only allows sampling
+// through a handle that isn't dynamically uniform with NV_gpu_shader5
+#ifdef TEXTURE_BINDLESS_PER_INSTANCE
+#extension GL_NV_gpu_shader5 : require
+#endif
+
+// triangle.frag with the images taken from the resident handles of the draw's or instance's
+// material, looked up per vertex from the MaterialTextures buffer (materials.glsl). Only built
+// as GLSL, there are no SPIR-V variants of the bindless programs.
+
+in vec3 ourColor;
+in vec2 TexCoord;
+// xy: handle of texture1, zw: handle of texture2
+flat in uvec4 textureHandles;
+
+out vec4 FragColor;
+
+void main()
+{
+#ifdef TEXTURE_MIX
+    FragColor = mix(texture(sampler2D(textureHandles.xy), TexCoord), texture(sampler2D(textureHandles.zw), TexCoord), 0.2);
+#else
+    FragColor = texture(sampler2D(textureHandles.xy), TexCoord);
+#endif
+#ifdef VERTEX_COLOR
+    FragColor.rgb *= ourColor;
+#endif
+}
@@ -0,0 +1,11 @@
+#include "spirv.glsl"
+
+// per-frame camera data, written once per frame and bound at FRAME_CONSTANTS_BINDING (frame_constants.h)
+STD140_BINDING(0) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    float time;
+};
@@ -0,0 +1,50 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+
+#include "spirv.glsl"
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aColor;
+layout(location = 2) in vec2 aTexCoord;
+
+layout(std430, binding = 0) readonly buffer InstanceModels
+{
+    mat4 models[];
+};
+
+out vec3 ourColor;
+out vec2 TexCoord;
+
+#if defined(TEXTURE_ARRAY) || defined(TEXTURE_BINDLESS)
+layout(std430, binding = 1) readonly buffer InstanceMaterials
+{
+    uint materials[];
+};
+
+#include "materials.glsl"
+#endif
+#ifdef TEXTURE_ARRAY
+flat out ivec2 layers;
+#elif defined(TEXTURE_BINDLESS)
+flat out uvec4 textureHandles;
+#endif
+
+#include "frame_constants.glsl"
+
+void main()
+{
+    mat4 world = models[gl_BaseInstanceARB + gl_InstanceID];
+    gl_Position = viewProjection * world * vec4(aPos, 1.0f);
+    ourColor = aColor;
+    TexCoord = aTexCoord;
+#ifdef TEXTURE_ARRAY
+    layers = materialLayers[materials[gl_BaseInstanceARB + gl_InstanceID]].xy;
+#elif defined(TEXTURE_BINDLESS)
+    textureHandles = materialTextures[materials[gl_BaseInstanceARB + gl_InstanceID]];
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#include "spirv.glsl"
+
+#ifdef TEXTURE_BINDLESS
+// resident texture handles of every material, bound at MATERIAL_TEXTURES_BINDING (bindless_materials.h)
+layout(std430, binding = 2) readonly buffer MaterialTextures
+{
+    // xy: handle of texture1, zw: handle of texture2
+    uvec4 materialTextures[];
+};
+#else
+// texture array layers of every material, written once the scene textures are packed and bound
+// at MATERIAL_LAYERS_BINDING (texture_array_packer.h)
+STD140_BINDING(1) uniform MaterialLayers
+{
+    // x: layer of texture1, y: layer of texture2
+    ivec4 materialLayers[256];
+};
+#endif
@@ -0,0 +1,17 @@
+#ifndef SPIRV_GLSL
+#define SPIRV_GLSL
+
+// GL_SPIRV is predefined when glslang compiles for GL_ARB_gl_spirv. SPIR-V carries no uniform
+// names, so loose uniforms need explicit locations (Shader reads the names back from these
+// declarations) and samplers and blocks explicit bindings. Plain GLSL sets both at runtime.
+#ifdef GL_SPIRV
+#define UNIFORM_LOCATION(n) layout(location = n)
+#define SAMPLER_BINDING(n) layout(binding = n)
+#define STD140_BINDING(n) layout(std140, binding = n)
+#else
+#define UNIFORM_LOCATION(n)
+#define SAMPLER_BINDING(n)
+#define STD140_BINDING(n) layout(std140)
+#endif
+
+#endif
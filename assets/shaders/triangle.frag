@@ -1,14 +1,41 @@
 #version 330 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+
+#include "spirv.glsl"
 
 in vec3 ourColor;
 in vec2 TexCoord;
 
 out vec4 FragColor;
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+#ifdef TEXTURE_ARRAY
+// both images of every material are layers of one array, picked per draw or instance
+flat in ivec2 layers;
+
+SAMPLER_BINDING(0) uniform sampler2DArray textures;
+
+vec4 sampleTexture1() { return texture(textures, vec3(TexCoord, layers.x)); }
+vec4 sampleTexture2() { return texture(textures, vec3(TexCoord, layers.y)); }
+#else
+SAMPLER_BINDING(0) uniform sampler2D texture1;
+SAMPLER_BINDING(1) uniform sampler2D texture2;
+
+vec4 sampleTexture1() { return texture(texture1, TexCoord); }
+vec4 sampleTexture2() { return texture(texture2, TexCoord); }
+#endif
 
 void main()
 {
-    FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);
+#ifdef TEXTURE_MIX
+    FragColor = mix(sampleTexture1(), sampleTexture2(), 0.2);
+#else
+    FragColor = sampleTexture1();
+#endif
+#ifdef VERTEX_COLOR
+    FragColor.rgb *= ourColor;
+#endif
 }
\ No newline at end of file
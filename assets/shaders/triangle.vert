@@ -1,19 +1,65 @@
 #version 330 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+#ifdef TEXTURE_BINDLESS
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+
+#include "spirv.glsl"
 
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aColor;
 layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in mat4 aInstanceModel;
 
 out vec3 ourColor;
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#ifndef INSTANCED
+UNIFORM_LOCATION(0) uniform mat4 model;
+#endif
+
+#if defined(TEXTURE_ARRAY) || defined(TEXTURE_BINDLESS)
+#ifdef INSTANCED
+layout(location = 7) in uint aMaterial;
+#else
+UNIFORM_LOCATION(1) uniform int materialIndex;
+#endif
+
+#include "materials.glsl"
+#endif
+#ifdef TEXTURE_ARRAY
+flat out ivec2 layers;
+#elif defined(TEXTURE_BINDLESS)
+flat out uvec4 textureHandles;
+#endif
+
+#include "frame_constants.glsl"
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+#ifdef INSTANCED
+    mat4 world = aInstanceModel;
+#else
+    mat4 world = model;
+#endif
+    gl_Position = viewProjection * world * vec4(aPos, 1.0f);
     ourColor = aColor;
     TexCoord = aTexCoord;
+#if defined(TEXTURE_ARRAY) || defined(TEXTURE_BINDLESS)
+#ifdef INSTANCED
+    uint material = aMaterial;
+#else
+    uint material = uint(materialIndex);
+#endif
+#endif
+#ifdef TEXTURE_ARRAY
+    layers = materialLayers[material].xy;
+#elif defined(TEXTURE_BINDLESS)
+    textureHandles = materialTextures[material];
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,309 @@
+// CPU cost of submitting draws that switch between many materials, each a pair of distinct 2D
+// textures, under the three texture models the app has: rebinding both texture units per
+// material (bound), one texture array with the layers picked by a material index (array), and
+// resident ARB_bindless_texture handles in a storage buffer indexed the same way (bindless).
+// Every frame is DRAWS small triangles sorted by material with one uniform update per draw;
+// only the time to issue the calls is measured, the GPU work is waited for outside of it.
+
+#include "bindless_materials.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "headless_context.h"
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr uint32_t DRAWS = 4096;
+static constexpr uint32_t FRAMES = 15;
+static constexpr int32_t TEXTURE_SIZE = 4;
+static constexpr int32_t TARGET_SIZE = 64;
+
+static const char* VERTEX_SOURCE = R"(#version 330 core
+uniform vec2 offset;
+void main()
+{
+    vec2 corner = vec2(gl_VertexID == 1 ? 1.0 : 0.0, gl_VertexID == 2 ? 1.0 : 0.0);
+    gl_Position = vec4(offset + corner * 0.05, 0.0, 1.0);
+}
+)";
+
+static const char* BOUND_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+out vec4 FragColor;
+void main()
+{
+    FragColor = mix(texture(texture1, vec2(0.5)), texture(texture2, vec2(0.5)), 0.2);
+}
+)";
+
+// both images of material m are layers 2m and 2m + 1
+static const char* ARRAY_FRAGMENT_SOURCE = R"(#version 330 core
+uniform sampler2DArray textures;
+uniform int materialIndex;
+out vec4 FragColor;
+void main()
+{
+    FragColor = mix(texture(textures, vec3(0.5, 0.5, 2 * materialIndex)), texture(textures, vec3(0.5, 0.5, 2 * materialIndex + 1)), 0.2);
+}
+)";
+
+// the table BindlessMaterialTable uploads, see assets/shaders/materials.glsl; the handles come from
+// a uniform index, so they are dynamically uniform as ARB_bindless_texture requires on its own
+static const char* BINDLESS_FRAGMENT_SOURCE = R"(#version 400 core
+#extension GL_ARB_bindless_texture : require
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shading_language_420pack : require
+layout(std430, binding = 2) readonly buffer MaterialTextures
+{
+    uvec4 materialTextures[];
+};
+uniform int materialIndex;
+out vec4 FragColor;
+void main()
+{
+    uvec4 handles = materialTextures[materialIndex];
+    FragColor = mix(texture(sampler2D(handles.xy), vec2(0.5)), texture(sampler2D(handles.zw), vec2(0.5)), 0.2);
+}
+)";
+
+struct Program
+{
+    uint32_t id = 0;
+    int32_t offset = -1;
+    int32_t material = -1;
+};
+
+static uint32_t compile(uint32_t type, const char* source)
+{
+    uint32_t shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    int32_t success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cout << "Failed to compile shader: " << log << std::endl;
+    }
+    return shader;
+}
+
+static Program link(const char* fragment_source)
+{
+    uint32_t vertex = compile(GL_VERTEX_SHADER, VERTEX_SOURCE);
+    uint32_t fragment = compile(GL_FRAGMENT_SHADER, fragment_source);
+    Program program{};
+    program.id = glCreateProgram();
+    glAttachShader(program.id, vertex);
+    glAttachShader(program.id, fragment);
+    glLinkProgram(program.id);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    int32_t success = 0;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &success);
+    if (!success) {
+        char log[1024];
+        glGetProgramInfoLog(program.id, sizeof(log), nullptr, log);
+        std::cout << "Failed to link program: " << log << std::endl;
+        glDeleteProgram(program.id);
+        return Program{};
+    }
+    gl_state.UseProgram(program.id);
+    glUniform1i(glGetUniformLocation(program.id, "texture1"), 0);
+    glUniform1i(glGetUniformLocation(program.id, "texture2"), 1);
+    glUniform1i(glGetUniformLocation(program.id, "textures"), 0);
+    program.offset = glGetUniformLocation(program.id, "offset");
+    program.material = glGetUniformLocation(program.id, "materialIndex");
+    return program;
+}
+
+// median CPU time to issue one frame in milliseconds; each frame is finished before the next starts
+static double measure_submit_ms(const std::function<void()>& frame)
+{
+    frame();
+    glFinish();
+    std::vector<double> samples;
+    for (uint32_t run = 0; run < FRAMES; ++run) {
+        auto start = bench_clock::now();
+        frame();
+        samples.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+        glFinish();
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[FRAMES / 2];
+}
+
+// the draws of one frame, sorted by material; set_material runs whenever the material changes
+static void submit(const Program& program, uint32_t materials, const std::function<void(uint32_t)>& set_material)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    gl_state.UseProgram(program.id);
+    uint32_t current = UINT32_MAX;
+    for (uint32_t draw = 0; draw < DRAWS; ++draw) {
+        uint32_t material = static_cast<uint32_t>(static_cast<uint64_t>(draw) * materials / DRAWS);
+        if (material != current) {
+            set_material(material);
+            current = material;
+        }
+        float x = static_cast<float>(draw % 64) / 32.0f - 1.0f;
+        float y = static_cast<float>(draw / 64 % 64) / 32.0f - 1.0f;
+        glUniform2f(program.offset, x, y);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+}
+
+// 2 * materials small textures with a distinct color each, so no two materials share an image
+static std::vector<uint32_t> create_textures(uint32_t materials)
+{
+    std::vector<uint32_t> textures(materials * MATERIAL_TEXTURE_UNITS);
+    glGenTextures(static_cast<int32_t>(textures.size()), textures.data());
+    std::vector<uint32_t> texels(TEXTURE_SIZE * TEXTURE_SIZE);
+    for (size_t i = 0; i < textures.size(); ++i) {
+        std::fill(texels.begin(), texels.end(), static_cast<uint32_t>(i * 2654435761u) | 0xFF000000u);
+        gl_state.BindTexture(0, GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    return textures;
+}
+
+// the same images as layers of one array, or 0 when they don't fit
+static uint32_t create_array(uint32_t materials)
+{
+    int32_t max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    int32_t layers = static_cast<int32_t>(materials * MATERIAL_TEXTURE_UNITS);
+    if (layers > max_layers) {
+        return 0;
+    }
+    uint32_t array = 0;
+    glGenTextures(1, &array);
+    gl_state.BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+    std::vector<uint32_t> texels(static_cast<size_t>(TEXTURE_SIZE * TEXTURE_SIZE) * layers);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        texels[i] = static_cast<uint32_t>(i / (TEXTURE_SIZE * TEXTURE_SIZE) * 2654435761u) | 0xFF000000u;
+    }
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return array;
+}
+
+static std::string format_ms(bool measured, double ms)
+{
+    if (!measured) {
+        return "n/a";
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << ms;
+    return text.str();
+}
+
+static void delete_textures(const std::vector<uint32_t>& textures)
+{
+    for (uint32_t texture : textures) {
+        gl_state.OnTextureDeleted(texture);
+    }
+    glDeleteTextures(static_cast<int32_t>(textures.size()), textures.data());
+}
+
+int main()
+{
+    HeadlessContext context{};
+    if (!context.Create(3, 3) || !gladLoadGLLoader(HeadlessContext::GetProcAddress)) {
+        std::cout << "No GL context" << std::endl;
+        return 1;
+    }
+    LoadGLExtensions(HeadlessContext::GetProcAddress);
+    gl_state.Invalidate();
+    std::cout << "GL: " << glGetString(GL_RENDERER) << std::endl;
+    bool bindless = BindlessMaterialTable::IsSupported();
+    if (!bindless) {
+        std::cout << "No ARB_bindless_texture, skipping the bindless model" << std::endl;
+    }
+
+    uint32_t color = 0;
+    glGenTextures(1, &color);
+    gl_state.BindTexture(0, GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TARGET_SIZE, TARGET_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    uint32_t framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glViewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+    // attribute-less draws still need a vertex array bound in the core profile
+    uint32_t vao = 0;
+    glGenVertexArrays(1, &vao);
+    gl_state.BindVertexArray(vao);
+
+    Program bound_program = link(BOUND_FRAGMENT_SOURCE);
+    Program array_program = link(ARRAY_FRAGMENT_SOURCE);
+    Program bindless_program = bindless ? link(BINDLESS_FRAGMENT_SOURCE) : Program{};
+
+    std::cout << DRAWS << " draws per frame, sorted by material, CPU submit time per frame in ms (median of " << FRAMES << ")" << std::endl;
+    std::cout << std::setw(10) << "materials" << std::setw(10) << "bound" << std::setw(10) << "array" << std::setw(10) << "bindless"
+              << std::setw(14) << "bound binds" << std::endl;
+    for (uint32_t materials : {1u, 64u, 1024u}) {
+        std::vector<uint32_t> textures = create_textures(materials);
+
+        gl_state.ResetCounts();
+        double bound_ms = measure_submit_ms([&]() {
+            submit(bound_program, materials, [&](uint32_t material) {
+                gl_state.BindTexture(0, GL_TEXTURE_2D, textures[material * MATERIAL_TEXTURE_UNITS]);
+                gl_state.BindTexture(1, GL_TEXTURE_2D, textures[material * MATERIAL_TEXTURE_UNITS + 1]);
+            });
+        });
+        uint64_t bound_binds = gl_state.GetCounts(GLStateCache::Counter::TEXTURE).issued / (FRAMES + 1);
+
+        uint32_t array = create_array(materials);
+        double array_ms = 0.0;
+        if (array) {
+            gl_state.BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+            array_ms = measure_submit_ms([&]() {
+                submit(array_program, materials, [&](uint32_t material) { glUniform1i(array_program.material, static_cast<int32_t>(material)); });
+            });
+            gl_state.OnTextureDeleted(array);
+            glDeleteTextures(1, &array);
+        }
+
+        double bindless_ms = 0.0;
+        if (bindless_program.id) {
+            BindlessMaterialTable table{};
+            for (uint32_t material = 0; material < materials; ++material) {
+                table.Add(Material{{textures[material * MATERIAL_TEXTURE_UNITS], textures[material * MATERIAL_TEXTURE_UNITS + 1]}});
+            }
+            table.Upload();
+            bindless_ms = measure_submit_ms([&]() {
+                submit(bindless_program, materials, [&](uint32_t material) { glUniform1i(bindless_program.material, static_cast<int32_t>(material)); });
+            });
+        }
+        delete_textures(textures);
+
+        std::cout << std::setw(10) << materials << std::setw(10) << format_ms(true, bound_ms) << std::setw(10) << format_ms(array != 0, array_ms)
+                  << std::setw(10) << format_ms(bindless_program.id != 0, bindless_ms) << std::setw(14) << bound_binds << std::endl;
+    }
+
+    for (const Program& program : {bound_program, array_program, bindless_program}) {
+        gl_state.OnProgramDeleted(program.id);
+        glDeleteProgram(program.id);
+    }
+    gl_state.OnVertexArrayDeleted(vao);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteFramebuffers(1, &framebuffer);
+    gl_state.OnTextureDeleted(color);
+    glDeleteTextures(1, &color);
+    return 0;
+}
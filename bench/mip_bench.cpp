@@ -0,0 +1,156 @@
+// Compares the CPU mip chain generator texbake uses (box and Kaiser, scalar, SSE and AVX2)
+// against glGenerateMipmap on whatever GL the headless context gets, llvmpipe on machines
+// without a GPU. Times cover the whole chain below level 0 as 8 bit texels.
+
+#include "mip_generator.h"
+#include "cpu_features.h"
+#include "headless_context.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+struct Image
+{
+    std::string name;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> rgba;
+};
+
+// median of several runs in milliseconds
+static double measure_ms(const std::function<void()>& body)
+{
+    constexpr uint32_t runs = 7;
+    body();
+    std::vector<double> samples;
+    for (uint32_t run = 0; run < runs; ++run) {
+        auto start = bench_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[runs / 2];
+}
+
+static bool load_image(const char* path, Image& image)
+{
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t channels = 0;
+    uint8_t* pixels = stbi_load(path, &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cout << "Failed to load image " << path << ", run from the repository root" << std::endl;
+        return false;
+    }
+    image.name = std::string{path}.substr(std::string{path}.find_last_of('/') + 1);
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+// largest difference of any texel in any level, in 8 bit steps
+static int32_t max_difference(const std::vector<MipLevel>& a, const std::vector<MipLevel>& b)
+{
+    int32_t diff = 0;
+    for (size_t level = 0; level < a.size(); ++level) {
+        for (size_t i = 0; i < a[level].rgba.size(); ++i) {
+            diff = std::max(diff, std::abs(static_cast<int32_t>(a[level].rgba[i]) - static_cast<int32_t>(b[level].rgba[i])));
+        }
+    }
+    return diff;
+}
+
+static double measure_gl_ms(const Image& image)
+{
+    uint32_t texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    std::vector<double> samples;
+    for (uint32_t run = 0; run < 7; ++run) {
+        // respecifying level 0 outside the timed part makes every run build the whole chain again
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<int32_t>(image.width), static_cast<int32_t>(image.height), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, image.rgba.data());
+        glFinish();
+        auto start = bench_clock::now();
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        samples.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+    }
+    glDeleteTextures(1, &texture);
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main()
+{
+    const CPUFeatures& features = GetCPUFeatures();
+    std::cout << "SIMD: " << (features.avx2 && features.fma ? "AVX2 (2 texels wide)" : "SSE (1 texel wide)") << std::endl;
+
+    std::vector<Image> images(2);
+    stbi_set_flip_vertically_on_load(true);
+    if (!load_image("assets/textures/container.jpg", images[0]) || !load_image("assets/textures/awesomeface.png", images[1])) {
+        return 1;
+    }
+    Image noise{"noise", 2048, 2048, std::vector<uint8_t>(2048 * 2048 * 4)};
+    std::mt19937 rng{42};
+    for (uint8_t& value : noise.rgba) {
+        value = static_cast<uint8_t>(rng());
+    }
+    images.push_back(std::move(noise));
+
+    HeadlessContext context{};
+    bool has_gl = context.Create(3, 3) && gladLoadGLLoader(HeadlessContext::GetProcAddress);
+    if (has_gl) {
+        std::cout << "GL: " << glGetString(GL_RENDERER) << std::endl;
+    } else {
+        std::cout << "No GL context, skipping glGenerateMipmap" << std::endl;
+    }
+
+    std::cout << std::setw(16) << "image" << std::setw(11) << "size" << std::setw(12) << "glGenMip" << std::setw(12)
+              << "box" << std::setw(12) << "box SSE" << std::setw(12) << "box AVX2" << std::setw(12) << "kaiser" << std::setw(12)
+              << "kaiser SSE" << std::setw(12) << "kaiser AVX2" << std::setw(10) << "max err" << "   (ms per chain)" << std::endl;
+    for (const Image& image : images) {
+        double gl_ms = has_gl ? measure_gl_ms(image) : 0.0;
+        std::vector<double> cpu_ms;
+        int32_t error = 0;
+        for (MipFilter filter : {MipFilter::BOX, MipFilter::KAISER}) {
+            MipOptions options{};
+            options.filter = filter;
+            // straight alpha images get the premultiplied path the bake uses for them
+            options.premultiply_alpha = image.name == "awesomeface.png";
+            std::vector<MipLevel> reference;
+            for (MipKernel kernel : {MipKernel::SCALAR, MipKernel::SSE, MipKernel::AVX2}) {
+                options.kernel = kernel;
+                std::vector<MipLevel> levels;
+                cpu_ms.push_back(measure_ms([&]() { levels = GenerateMipChain(image.rgba.data(), image.width, image.height, options); }));
+                if (reference.empty()) {
+                    reference = std::move(levels);
+                } else {
+                    error = std::max(error, max_difference(reference, levels));
+                }
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(2) << std::setw(16) << image.name << std::setw(11)
+                  << (std::to_string(image.width) + "x" + std::to_string(image.height)) << std::setw(12) << gl_ms;
+        for (double ms : cpu_ms) {
+            std::cout << std::setw(12) << ms;
+        }
+        std::cout << std::setw(10) << error << std::endl;
+    }
+    return 0;
+}
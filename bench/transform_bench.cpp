@@ -0,0 +1,101 @@
+// Compares the per-object glm::translate + glm::rotate path main.cpp used to run against the
+// SoA TransformSystem (scalar and SIMD) for 10k, 100k and 1M transforms.
+
+#include "transform_system.h"
+#include "cpu_features.h"
+
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// median of several runs, each repeated until it covers a measurable amount of time
+static double measure_ns_per_object(size_t count, const std::function<void()>& body)
+{
+    constexpr uint32_t runs = 7;
+    uint32_t repeats = static_cast<uint32_t>(std::max<size_t>(1, 2000000 / count));
+    body();
+    std::vector<double> samples;
+    for (uint32_t run = 0; run < runs; ++run) {
+        auto start = bench_clock::now();
+        for (uint32_t i = 0; i < repeats; ++i) {
+            body();
+        }
+        double ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+        samples.push_back(ns / static_cast<double>(repeats) / static_cast<double>(count));
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[runs / 2];
+}
+
+static float max_difference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (int32_t column = 0; column < 4; ++column) {
+            for (int32_t row = 0; row < 4; ++row) {
+                diff = std::max(diff, std::fabs(a[i][column][row] - b[i][column][row]));
+            }
+        }
+    }
+    return diff;
+}
+
+int main()
+{
+    const CPUFeatures& features = GetCPUFeatures();
+    std::cout << "SIMD: " << (features.avx2 && features.fma ? "AVX2 (8 wide)" : "SSE (4 wide)") << std::endl;
+    std::cout << std::setw(10) << "objects" << std::setw(16) << "glm AoS" << std::setw(16) << "SoA scalar" << std::setw(16)
+              << "SoA SIMD" << std::setw(20) << "SoA rotate+SIMD" << std::setw(10) << "speedup" << std::setw(12) << "max err"
+              << "   (ns/object)" << std::endl;
+
+    const glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+    for (size_t count : {size_t{10000}, size_t{100000}, size_t{1000000}}) {
+        std::mt19937 rng{42};
+        std::uniform_real_distribution<float> spread{-50.0f, 50.0f};
+        std::uniform_real_distribution<float> angles{0.0f, 6.28f};
+        std::vector<glm::vec3> positions(count);
+        std::vector<float> rotations(count);
+        TransformSystem transforms;
+        transforms.Reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            positions[i] = glm::vec3{spread(rng), spread(rng), spread(rng)};
+            rotations[i] = angles(rng);
+            transforms.Add(positions[i], glm::angleAxis(rotations[i], axis), glm::vec3{1.0f});
+        }
+
+        std::vector<glm::mat4> reference(count);
+        std::vector<glm::mat4> output(count);
+        double glm_ns = measure_ns_per_object(count, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                glm::mat4 model = glm::translate(glm::mat4{1.0f}, positions[i]);
+                reference[i] = glm::rotate(model, rotations[i], glm::vec3(1.0f, 0.3f, 0.5f));
+            }
+        });
+        double scalar_ns = measure_ns_per_object(count, [&]() { transforms.ComposeMatricesScalar(output.data()); });
+        double simd_ns = measure_ns_per_object(count, [&]() { transforms.ComposeMatrices(output.data()); });
+        float error = max_difference(reference, output);
+        double update_ns = measure_ns_per_object(count, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                transforms.SetRotation(static_cast<uint32_t>(i), glm::angleAxis(rotations[i], axis));
+            }
+            transforms.ComposeMatrices(output.data());
+        });
+
+        std::cout << std::fixed << std::setprecision(2) << std::setw(10) << count << std::setw(16) << glm_ns << std::setw(16)
+                  << scalar_ns << std::setw(16) << simd_ns << std::setw(20) << update_ns << std::setw(9) << glm_ns / simd_ns << "x"
+                  << std::setw(12) << std::scientific << std::setprecision(1) << error << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+# Compiles GLSL permutations to SPIR-V for the GL_ARB_gl_spirv loading path in Shader. glslang
+# validates every module, so a broken shader fails the build. Module names must match
+# SpirvModulePath() in src/shader.cpp: <file>[+NAME[=VALUE]...].spv with the defines sorted.
+
+set(SPIRV_SHADER_SOURCE_DIR ${CMAKE_SOURCE_DIR}/assets/shaders)
+set(SPIRV_SHADER_OUTPUT_DIR ${CMAKE_BINARY_DIR}/spirv)
+
+# spirv_shader_variant(<vertex file> <fragment file> [DEFINE[=VALUE]...])
+function(spirv_shader_variant vert frag)
+    set(defines ${ARGN})
+    list(SORT defines)
+    set(suffix "")
+    set(define_flags "")
+    foreach(define ${defines})
+        string(APPEND suffix "+${define}")
+        list(APPEND define_flags "-D${define}")
+    endforeach()
+
+    foreach(stage_file ${vert} ${frag})
+        set(output ${SPIRV_SHADER_OUTPUT_DIR}/${stage_file}${suffix}.spv)
+        # both stages of every permutation are listed, so shared modules come up more than once
+        get_property(known GLOBAL PROPERTY SPIRV_SHADER_MODULES)
+        if (output IN_LIST known)
+            continue()
+        endif()
+        set_property(GLOBAL APPEND PROPERTY SPIRV_SHADER_MODULES ${output})
+        # --aml numbers the stage interface in declaration order, which the vertex and fragment
+        # shaders keep in sync
+        add_custom_command(
+            OUTPUT ${output}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${SPIRV_SHADER_OUTPUT_DIR}
+            COMMAND ${GLSLANG_VALIDATOR} -G --aml ${define_flags} -o ${output} ${SPIRV_SHADER_SOURCE_DIR}/${stage_file}
+            DEPENDS ${SPIRV_SHADER_SOURCE_DIR}/${stage_file} ${SPIRV_SHADER_INCLUDES}
+            COMMENT "Compiling ${stage_file}${suffix} to SPIR-V"
+            VERBATIM)
+    endforeach()
+endfunction()
+
+find_program(GLSLANG_VALIDATOR glslangValidator)
+if (GLSLANG_VALIDATOR)
+    message(STATUS "Using glslang: ${GLSLANG_VALIDATOR}")
+    file(GLOB SPIRV_SHADER_INCLUDES ${SPIRV_SHADER_SOURCE_DIR}/*.glsl)
+
+    # the permutations create_scene() asks for
+    spirv_shader_variant(triangle.vert triangle.frag TEXTURE_MIX)
+    spirv_shader_variant(triangle.vert triangle.frag INSTANCED TEXTURE_MIX)
+    spirv_shader_variant(indirect.vert triangle.frag TEXTURE_MIX)
+    spirv_shader_variant(triangle.vert triangle.frag TEXTURE_ARRAY TEXTURE_MIX)
+    spirv_shader_variant(triangle.vert triangle.frag INSTANCED TEXTURE_ARRAY TEXTURE_MIX)
+    spirv_shader_variant(indirect.vert triangle.frag TEXTURE_ARRAY TEXTURE_MIX)
+
+    get_property(SPIRV_SHADER_MODULES GLOBAL PROPERTY SPIRV_SHADER_MODULES)
+    add_custom_target(spirv-shaders ALL DEPENDS ${SPIRV_SHADER_MODULES})
+    add_dependencies(main_obj spirv-shaders)
+    target_compile_definitions(main_obj PRIVATE SPIRV_SHADER_DIR="${SPIRV_SHADER_OUTPUT_DIR}")
+else ()
+    message(STATUS "glslangValidator not found, shaders are compiled from GLSL at runtime")
+endif ()
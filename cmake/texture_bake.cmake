@@ -0,0 +1,30 @@
+# Compresses the textures under assets/textures into KTX2 containers with texbake. The loader
+# looks for <file>.ktx2 in BAKED_TEXTURE_DIR and falls back to decoding <file> itself when the
+# container is missing or the GL can't sample its format.
+
+set(BAKED_TEXTURE_SOURCE_DIR ${CMAKE_SOURCE_DIR}/assets/textures)
+set(BAKED_TEXTURE_OUTPUT_DIR ${CMAKE_BINARY_DIR}/textures)
+
+# bake_texture(<file> <auto|bc1|bc3|bc7> [texbake flags...])
+function(bake_texture file format)
+    set(output ${BAKED_TEXTURE_OUTPUT_DIR}/${file}.ktx2)
+    set_property(GLOBAL APPEND PROPERTY BAKED_TEXTURES ${output})
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${BAKED_TEXTURE_OUTPUT_DIR}
+        COMMAND texbake --format ${format} ${ARGN} ${BAKED_TEXTURE_SOURCE_DIR}/${file} ${output}
+        DEPENDS texbake ${BAKED_TEXTURE_SOURCE_DIR}/${file}
+        COMMENT "Baking ${file} to ${format}"
+        VERBATIM)
+endfunction()
+
+# the textures load_textures() asks for. Both share BC3 so --textures array can keep them in one
+# compressed array; BC7 would look better but software rasterizers decode it per sample, which
+# made llvmpipe draw the scene more than ten times slower
+bake_texture(container.jpg bc3)
+bake_texture(awesomeface.png bc3 --premultiply)
+
+get_property(BAKED_TEXTURES GLOBAL PROPERTY BAKED_TEXTURES)
+add_custom_target(bake-textures ALL DEPENDS ${BAKED_TEXTURES})
+add_dependencies(main_obj bake-textures)
+target_compile_definitions(main_obj PRIVATE BAKED_TEXTURE_DIR="${BAKED_TEXTURE_OUTPUT_DIR}")
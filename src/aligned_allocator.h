@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+
+// std::allocator replacement for SIMD arrays so the start of every vector is usable with aligned loads
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        ::operator delete(ptr, std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const
+    {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const
+    {
+        return false;
+    }
+};
@@ -0,0 +1,58 @@
+#include "bindless_materials.h"
+#include "gl_extensions.h"
+
+#include <algorithm>
+#include <iostream>
+
+BindlessMaterialTable::BindlessMaterialTable()
+    : buffer_(0)
+{
+}
+
+BindlessMaterialTable::~BindlessMaterialTable()
+{
+    for (uint64_t handle : resident_) {
+        glMakeTextureHandleNonResidentARB(handle);
+    }
+    glDeleteBuffers(1, &buffer_);
+}
+
+bool BindlessMaterialTable::IsSupported(bool per_instance)
+{
+    return gl_capabilities.bindless_texture && (!per_instance || gl_capabilities.gpu_shader5_nv);
+}
+
+uint32_t BindlessMaterialTable::Add(const Material& material)
+{
+    for (uint32_t texture : material.textures) {
+        handles_.push_back(texture ? MakeResident(texture) : 0);
+    }
+    return static_cast<uint32_t>(handles_.size() / MATERIAL_TEXTURE_UNITS - 1);
+}
+
+void BindlessMaterialTable::Upload()
+{
+    if (!buffer_) {
+        glGenBuffers(1, &buffer_);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(handles_.size() * sizeof(uint64_t)), handles_.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TEXTURES_BINDING, buffer_);
+}
+
+void BindlessMaterialTable::PrintStats() const
+{
+    std::cout << "Bindless materials: " << handles_.size() / MATERIAL_TEXTURE_UNITS << " materials, " << resident_.size()
+              << " resident textures" << std::endl;
+}
+
+uint64_t BindlessMaterialTable::MakeResident(uint32_t texture)
+{
+    // the same texture always yields the same handle, and making it resident twice is an error
+    uint64_t handle = glGetTextureHandleARB(texture);
+    if (std::find(resident_.begin(), resident_.end(), handle) == resident_.end()) {
+        glMakeTextureHandleResidentARB(handle);
+        resident_.push_back(handle);
+    }
+    return handle;
+}
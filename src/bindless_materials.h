@@ -0,0 +1,45 @@
+#pragma once
+
+#include "render_queue.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Shader storage binding point of the MaterialTextures block in assets/shaders/materials.glsl:
+// one uvec4 per material, the handle of its first texture in xy and of its second in zw.
+inline constexpr uint32_t MATERIAL_TEXTURES_BINDING = 2;
+
+// Makes the textures of every material resident through ARB_bindless_texture and keeps their
+// 64-bit handles in a shader storage buffer that shaders index with the material of the draw or
+// instance, so changing materials never touches a texture unit. Taking a handle freezes a
+// texture's storage, so only add materials whose textures are fully loaded.
+class BindlessMaterialTable
+{
+public:
+    BindlessMaterialTable();
+    // makes the handles non-resident again; destroy the table before deleting its textures
+    ~BindlessMaterialTable();
+    BindlessMaterialTable(const BindlessMaterialTable&) = delete;
+    BindlessMaterialTable& operator=(const BindlessMaterialTable&) = delete;
+
+public:
+    // ARB_bindless_texture with GLSL 4.00 plus shader storage buffers. per_instance: the shaders pick
+    // the material per instance, so a handle can differ within a draw, which needs NV_gpu_shader5
+    static bool IsSupported(bool per_instance = false);
+
+    // returns the index shaders look the material up with; texture 0 leaves its slot empty
+    uint32_t Add(const Material& material);
+    // writes every material added so far into the buffer and binds it at MATERIAL_TEXTURES_BINDING
+    void Upload();
+    void PrintStats() const;
+
+private:
+    uint64_t MakeResident(uint32_t texture);
+
+private:
+    uint32_t buffer_;
+    // MATERIAL_TEXTURE_UNITS handles per material, 0 for empty slots
+    std::vector<uint64_t> handles_;
+    // every distinct handle made resident, a texture shared by several materials only once
+    std::vector<uint64_t> resident_;
+};
@@ -8,14 +8,14 @@ Camera::Camera(const glm::vec3& position, const glm::vec3& up, float yaw, float
     : position_(position), world_up_(up), yaw_(yaw), pitch_(pitch), front_(glm::vec3{0.0f, 0.0f, -1.0f}), 
         movement_speed_(SPEED), mouse_sensitivity_(SENSITIVITY), zoom_(ZOOM)
 {
-
+    UpdateCameraVectors();
 }
 
 Camera::Camera(glm::vec3&& position, glm::vec3&& up, float yaw, float pitch)
     : position_(position), world_up_(up), yaw_(yaw), pitch_(pitch), front_(glm::vec3{0.0f, 0.0f, -1.0f}), 
         movement_speed_(SPEED), mouse_sensitivity_(SENSITIVITY), zoom_(ZOOM)
 {
-
+    UpdateCameraVectors();
 }
 
 
@@ -84,6 +84,40 @@ float Camera::GetZoom() const
     return zoom_;
 }
 
+const glm::vec3& Camera::GetPosition() const
+{
+    return position_;
+}
+
+Frustum Camera::GetFrustum(const glm::mat4& projection) const
+{
+    return ExtractFrustum(projection * GetViewMatrix());
+}
+
+// Gribb/Hartmann: every clip plane is the w row plus or minus one of the x/y/z rows
+Frustum Camera::ExtractFrustum(const glm::mat4& view_projection)
+{
+    auto row = [&view_projection](int32_t index) {
+        return glm::vec4{view_projection[0][index], view_projection[1][index], view_projection[2][index], view_projection[3][index]};
+    };
+    glm::vec4 x = row(0);
+    glm::vec4 y = row(1);
+    glm::vec4 z = row(2);
+    glm::vec4 w = row(3);
+
+    Frustum frustum{};
+    frustum.planes[Frustum::PLANE_LEFT] = w + x;
+    frustum.planes[Frustum::PLANE_RIGHT] = w - x;
+    frustum.planes[Frustum::PLANE_BOTTOM] = w + y;
+    frustum.planes[Frustum::PLANE_TOP] = w - y;
+    frustum.planes[Frustum::PLANE_NEAR] = w + z;
+    frustum.planes[Frustum::PLANE_FAR] = w - z;
+    for (glm::vec4& plane : frustum.planes) {
+        plane = plane * (1.0f / glm::length(glm::vec3{plane.x, plane.y, plane.z}));
+    }
+    return frustum;
+}
+
 void Camera::UpdateCameraVectors()
 {
     glm::vec3 front{};
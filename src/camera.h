@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <array>
 #include <vector>
 
 inline constexpr float YAW = -90.0f;
@@ -17,6 +18,23 @@ enum class CameraMovement
     RIGHT
 };
 
+// planes are (normal, distance) pointing inwards: a point p is inside when dot(normal, p) + distance >= 0
+struct Frustum
+{
+    enum Plane
+    {
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANE_COUNT
+    };
+
+    std::array<glm::vec4, PLANE_COUNT> planes;
+};
+
 class Camera
 {
 public:
@@ -30,6 +48,9 @@ public:
     void ProcessMouseMovement(float x_offset, float y_offset, bool constrain_pitch);
     void ProcessMouseScroll(float y_offset);
     float GetZoom() const;
+    const glm::vec3& GetPosition() const;
+    Frustum GetFrustum(const glm::mat4& projection) const;
+    static Frustum ExtractFrustum(const glm::mat4& view_projection);
 
 private:
     void UpdateCameraVectors();
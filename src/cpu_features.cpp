@@ -0,0 +1,71 @@
+#include "cpu_features.h"
+
+#include <stdint.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define CPU_FEATURES_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_FEATURES_X86 1
+#endif
+
+#if defined(CPU_FEATURES_X86)
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int32_t out[4];
+    __cpuidex(out, static_cast<int32_t>(leaf), static_cast<int32_t>(subleaf));
+    for (int32_t i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// the OS has to save the upper YMM halves on context switches, otherwise AVX is unusable
+static bool os_saves_ymm()
+{
+#if defined(_MSC_VER)
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    uint64_t xcr0 = (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+#endif
+
+static CPUFeatures detect_cpu_features()
+{
+    CPUFeatures features{};
+#if defined(CPU_FEATURES_X86)
+    uint32_t regs[4] = {};
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return features;
+    }
+    cpuid(1, 0, regs);
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0 && osxsave && os_saves_ymm();
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    if (avx && max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = (regs[1] & (1u << 5)) != 0;
+        features.fma = fma;
+    }
+#endif
+    return features;
+}
+
+const CPUFeatures& GetCPUFeatures()
+{
+    static const CPUFeatures features = detect_cpu_features();
+    return features;
+}
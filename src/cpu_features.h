@@ -0,0 +1,23 @@
+#pragma once
+
+// x86 SIMD levels the CPU and OS both support, queried once on first use. Hot loops check
+// these to pick between AVX2, SSE and scalar kernels; non-x86 builds report everything off.
+struct CPUFeatures
+{
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+};
+
+const CPUFeatures& GetCPUFeatures();
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#endif
+
+// GCC and clang only emit AVX2 instructions inside functions tagged for it; MSVC always can
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
@@ -0,0 +1,137 @@
+#include "dynamic_ring_buffer.h"
+#include "gl_extensions.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+DynamicRingBuffer::DynamicRingBuffer(size_t frame_size, uint32_t frame_count)
+    : buffer_id_(0), frame_size_(align_up(frame_size, 256)), frame_count_(frame_count), region_(0), region_offset_(0), head_(0),
+        persistent_(gl_capabilities.buffer_storage), mapped_(false), mapping_(nullptr), frame_data_(nullptr), fences_{}, frames_(0), fence_waits_(0), fence_wait_ms_(0.0)
+{
+    if (frame_count_ == 0 || frame_count_ > sizeof(fences_) / sizeof(fences_[0])) {
+        throw std::runtime_error("DynamicRingBuffer: unsupported frame count");
+    }
+    size_t total_size = frame_size_ * frame_count_;
+    glGenBuffers(1, &buffer_id_);
+    // bind to a target no VAO or draw call cares about
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_id_);
+    if (persistent_) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(total_size), nullptr, flags);
+        mapping_ = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(total_size), flags));
+        if (!mapping_) {
+            throw std::runtime_error("DynamicRingBuffer: failed to map persistent buffer");
+        }
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(total_size), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+DynamicRingBuffer::~DynamicRingBuffer()
+{
+    for (GLsync fence : fences_) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (persistent_) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_id_);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer_id_);
+}
+
+void DynamicRingBuffer::BeginFrame()
+{
+    WaitForRegion(region_);
+    region_offset_ = region_ * frame_size_;
+    head_ = 0;
+    if (!persistent_) {
+        // the fence already guarantees the GPU is done with this region, so skip the driver's own sync
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_id_);
+        void* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(region_offset_), static_cast<GLsizeiptr>(frame_size_),
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (!data) {
+            throw std::runtime_error("DynamicRingBuffer: failed to map frame region");
+        }
+        frame_data_ = static_cast<uint8_t*>(data);
+        mapped_ = true;
+    } else {
+        frame_data_ = mapping_ + region_offset_;
+    }
+}
+
+RingAllocation DynamicRingBuffer::Allocate(size_t size, size_t alignment)
+{
+    size_t start = align_up(region_offset_ + head_, alignment);
+    if (start + size > region_offset_ + frame_size_) {
+        throw std::runtime_error("DynamicRingBuffer: frame region exhausted");
+    }
+    head_ = start + size - region_offset_;
+    return RingAllocation{frame_data_ + (start - region_offset_), start, size};
+}
+
+void DynamicRingBuffer::Commit()
+{
+    if (mapped_) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_id_);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped_ = false;
+    }
+}
+
+void DynamicRingBuffer::EndFrame()
+{
+    Commit();
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region_ = (region_ + 1) % frame_count_;
+    ++frames_;
+}
+
+uint32_t DynamicRingBuffer::GetBufferId() const
+{
+    return buffer_id_;
+}
+
+bool DynamicRingBuffer::IsPersistent() const
+{
+    return persistent_;
+}
+
+void DynamicRingBuffer::PrintStats() const
+{
+    double wait_ratio = frames_ ? 100.0 * static_cast<double>(fence_waits_) / static_cast<double>(frames_) : 0.0;
+    std::cout << "Ring buffer (" << (persistent_ ? "persistent" : "mapped per frame") << ", " << frame_count_ << " x "
+        << frame_size_ / 1024 << " KiB): " << fence_waits_ << " fence waits in " << frames_ << " frames (" << wait_ratio
+        << "%), " << fence_wait_ms_ << " ms blocked" << std::endl;
+}
+
+void DynamicRingBuffer::WaitForRegion(uint32_t region)
+{
+    GLsync fence = fences_[region];
+    if (!fence) {
+        return;
+    }
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        ++fence_waits_;
+        auto start = std::chrono::steady_clock::now();
+        constexpr GLuint64 timeout_ns = 1000000;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        fence_wait_ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fence);
+    fences_[region] = nullptr;
+}
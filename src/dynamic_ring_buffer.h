@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <glad/glad.h>
+
+struct RingAllocation
+{
+    void* data;
+    size_t offset;
+    size_t size;
+};
+
+// One GL buffer split into frame_count regions for transient per-frame data. With
+// ARB_buffer_storage the whole buffer stays persistently mapped and coherent, so writes
+// land in GPU-visible memory without any driver copy. Each region is fenced when its
+// frame is submitted and only reused once the GPU has signalled that fence.
+//
+// Usage per frame: BeginFrame, Allocate + write, Commit, issue draws, EndFrame.
+class DynamicRingBuffer
+{
+public:
+    DynamicRingBuffer(size_t frame_size, uint32_t frame_count);
+    ~DynamicRingBuffer();
+
+public:
+    void BeginFrame();
+    RingAllocation Allocate(size_t size, size_t alignment);
+    // makes this frame's writes visible to GL; no allocations are allowed after it
+    void Commit();
+    void EndFrame();
+
+    uint32_t GetBufferId() const;
+    bool IsPersistent() const;
+    void PrintStats() const;
+
+private:
+    void WaitForRegion(uint32_t region);
+
+private:
+    uint32_t buffer_id_;
+    size_t frame_size_;
+    uint32_t frame_count_;
+    uint32_t region_;
+    size_t region_offset_;
+    size_t head_;
+    bool persistent_;
+    bool mapped_;
+    uint8_t* mapping_;
+    uint8_t* frame_data_;
+    GLsync fences_[8];
+
+    uint64_t frames_;
+    uint64_t fence_waits_;
+    double fence_wait_ms_;
+};
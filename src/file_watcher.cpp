@@ -0,0 +1,107 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher()
+    : fd_(-1)
+{
+#if defined(__linux__)
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        std::cout << "inotify_init1 failed (" << std::strerror(errno) << "), polling modification times instead" << std::endl;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+void FileWatcher::Watch(const std::filesystem::path& file)
+{
+    std::filesystem::path path = Normalize(file);
+    std::error_code error;
+    files_[path.string()] = std::filesystem::last_write_time(path, error);
+#if defined(__linux__)
+    if (fd_ < 0) {
+        return;
+    }
+    std::filesystem::path directory = path.parent_path();
+    for (const auto& [descriptor, watched] : directories_) {
+        if (watched == directory) {
+            return;
+        }
+    }
+    int32_t descriptor = inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0) {
+        std::cout << "Cannot watch " << directory << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    directories_[descriptor] = directory;
+#endif
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll()
+{
+    std::vector<std::filesystem::path> changed;
+#if defined(__linux__)
+    if (fd_ >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(fd_, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                auto directory = directories_.find(event->wd);
+                if (directory == directories_.end() || event->len == 0) {
+                    continue;
+                }
+                std::filesystem::path path = directory->second / event->name;
+                if (files_.count(path.string()) &&
+                    std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                    changed.push_back(path);
+                }
+            }
+        }
+        return changed;
+    }
+#endif
+    // stat every watched file at most 4 times a second
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_scan_ < std::chrono::milliseconds(250)) {
+        return changed;
+    }
+    last_scan_ = now;
+    for (auto& [name, write_time] : files_) {
+        std::error_code error;
+        auto current = std::filesystem::last_write_time(name, error);
+        if (!error && current != write_time) {
+            write_time = current;
+            changed.emplace_back(name);
+        }
+    }
+    return changed;
+}
+
+std::filesystem::path FileWatcher::Normalize(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::filesystem::path normalized = std::filesystem::weakly_canonical(path, error);
+    return error ? std::filesystem::absolute(path) : normalized;
+}
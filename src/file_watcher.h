@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files that were written since the last Poll(). On Linux this is inotify on the
+// parent directories (so editors that save through a rename are caught too); elsewhere it
+// falls back to comparing modification times a few times per second. Poll() never blocks.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+public:
+    void Watch(const std::filesystem::path& file);
+    std::vector<std::filesystem::path> Poll();
+
+private:
+    static std::filesystem::path Normalize(const std::filesystem::path& path);
+
+private:
+    int32_t fd_;
+    std::unordered_map<int32_t, std::filesystem::path> directories_;
+    std::unordered_map<std::string, std::filesystem::file_time_type> files_;
+    std::chrono::steady_clock::time_point last_scan_;
+};
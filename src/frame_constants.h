@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+// Uniform buffer binding point every program's FrameConstants block is attached to at link time.
+inline constexpr uint32_t FRAME_CONSTANTS_BINDING = 0;
+inline constexpr const char* FRAME_CONSTANTS_BLOCK = "FrameConstants";
+
+// std140 mirror of the FrameConstants block shared by all vertex shaders. Written once per
+// frame into the ring and bound with a single glBindBufferRange, so the per-frame camera
+// upload cost no longer scales with the number of programs.
+struct FrameConstants
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    // vec3 + float pack into one std140 vec4 slot
+    glm::vec3 camera_position;
+    float time;
+};
+
+static_assert(sizeof(FrameConstants) == 208, "FrameConstants must match the std140 block layout");
@@ -0,0 +1,214 @@
+#include "frame_profiler.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static constexpr const char* PHASE_NAMES[FRAME_PHASE_COUNT] = {
+    "input",
+    "cull",
+    "matrix_build",
+    "uniform_upload",
+    "draw_submit",
+    "swap"
+};
+
+FrameProfiler::FrameProfiler()
+    : gpu_frames_{}, gpu_frame_index_(0), gpu_frames_dropped_(0), phase_ms_{}, phase_used_{}
+{
+    for (GpuFrame& frame : gpu_frames_) {
+        glGenQueries(static_cast<int32_t>(frame.queries.size()), frame.queries.data());
+        frame.issued.fill(false);
+        frame.pending = false;
+    }
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    for (GpuFrame& frame : gpu_frames_) {
+        glDeleteQueries(static_cast<int32_t>(frame.queries.size()), frame.queries.data());
+    }
+}
+
+void FrameProfiler::BeginFrame()
+{
+    // this slot was issued QUERY_LATENCY frames ago, which is normally long enough for the GPU to finish it
+    GpuFrame& frame = gpu_frames_[gpu_frame_index_];
+    if (frame.pending) {
+        CollectGpuFrame(frame);
+    }
+    frame.issued.fill(false);
+    frame.issued[FRAME_PHASE_COUNT] = true;
+    glQueryCounter(frame.queries[FRAME_PHASE_COUNT * 2], GL_TIMESTAMP);
+
+    phase_ms_.fill(0.0f);
+    phase_used_.fill(false);
+    frame_start_ = Clock::now();
+}
+
+void FrameProfiler::EndFrame()
+{
+    float frame_ms = std::chrono::duration<float, std::milli>(Clock::now() - frame_start_).count();
+    cpu_samples_[FRAME_PHASE_COUNT].push_back(frame_ms);
+    for (uint32_t phase = 0; phase < FRAME_PHASE_COUNT; ++phase) {
+        if (phase_used_[phase]) {
+            cpu_samples_[phase].push_back(phase_ms_[phase]);
+        }
+    }
+
+    GpuFrame& frame = gpu_frames_[gpu_frame_index_];
+    glQueryCounter(frame.queries[FRAME_PHASE_COUNT * 2 + 1], GL_TIMESTAMP);
+    frame.pending = true;
+    gpu_frame_index_ = (gpu_frame_index_ + 1) % QUERY_LATENCY;
+}
+
+void FrameProfiler::BeginPhase(FramePhase phase)
+{
+    uint32_t index = static_cast<uint32_t>(phase);
+    GpuFrame& frame = gpu_frames_[gpu_frame_index_];
+    if (!frame.issued[index]) {
+        glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+    }
+    phase_start_[index] = Clock::now();
+}
+
+void FrameProfiler::EndPhase(FramePhase phase)
+{
+    uint32_t index = static_cast<uint32_t>(phase);
+    phase_ms_[index] += std::chrono::duration<float, std::milli>(Clock::now() - phase_start_[index]).count();
+    phase_used_[index] = true;
+    // a phase entered several times in one frame spans from its first begin to its last end on the GPU
+    GpuFrame& frame = gpu_frames_[gpu_frame_index_];
+    glQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP);
+    frame.issued[index] = true;
+}
+
+void FrameProfiler::CollectGpuFrame(GpuFrame& frame)
+{
+    frame.pending = false;
+    // the frame-end timestamp is the last one issued, so once it is available all of them are
+    int32_t available = 0;
+    glGetQueryObjectiv(frame.queries[FRAME_PHASE_COUNT * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        ++gpu_frames_dropped_;
+        return;
+    }
+    for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        if (!frame.issued[slot]) {
+            continue;
+        }
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        glGetQueryObjectui64v(frame.queries[slot * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[slot * 2 + 1], GL_QUERY_RESULT, &end);
+        gpu_samples_[slot].push_back(end > begin ? static_cast<float>(end - begin) / 1.0e6f : 0.0f);
+    }
+}
+
+FrameProfiler::Summary FrameProfiler::Summarize(std::vector<float> samples)
+{
+    Summary summary{};
+    summary.samples = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](float p) {
+        return samples[static_cast<size_t>(p * static_cast<float>(samples.size() - 1) + 0.5f)];
+    };
+    double sum = 0.0;
+    for (float sample : samples) {
+        sum += sample;
+    }
+    summary.mean = static_cast<float>(sum / static_cast<double>(samples.size()));
+    summary.p50 = percentile(0.50f);
+    summary.p95 = percentile(0.95f);
+    summary.p99 = percentile(0.99f);
+    summary.max = samples.back();
+    return summary;
+}
+
+const char* FrameProfiler::SlotName(uint32_t slot)
+{
+    return slot < FRAME_PHASE_COUNT ? PHASE_NAMES[slot] : "frame";
+}
+
+void FrameProfiler::PrintReport() const
+{
+    std::cout << "Frame phases (ms)           samples     mean      p50      p95      p99      max" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const char* source : {"cpu", "gpu"}) {
+        const auto& samples = source[0] == 'c' ? cpu_samples_ : gpu_samples_;
+        for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+            Summary summary = Summarize(samples[slot]);
+            if (summary.samples == 0) {
+                continue;
+            }
+            std::cout << "  " << source << " " << std::left << std::setw(20) << SlotName(slot) << std::right
+                << std::setw(9) << summary.samples << std::setw(9) << summary.mean << std::setw(9) << summary.p50
+                << std::setw(9) << summary.p95 << std::setw(9) << summary.p99 << std::setw(9) << summary.max << std::endl;
+        }
+    }
+    std::cout << std::defaultfloat;
+    if (gpu_frames_dropped_ > 0) {
+        std::cout << "  " << gpu_frames_dropped_ << " GPU frames skipped because their queries were not ready" << std::endl;
+    }
+}
+
+bool FrameProfiler::WriteCsv(const std::filesystem::path& file_path) const
+{
+    std::ofstream file{file_path};
+    if (!file) {
+        std::cout << "Failed to write " << file_path.string() << std::endl;
+        return false;
+    }
+    file << "source,phase,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    for (const char* source : {"cpu", "gpu"}) {
+        const auto& samples = source[0] == 'c' ? cpu_samples_ : gpu_samples_;
+        for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+            Summary summary = Summarize(samples[slot]);
+            file << source << ',' << SlotName(slot) << ',' << summary.samples << ',' << summary.mean << ',' << summary.p50
+                << ',' << summary.p95 << ',' << summary.p99 << ',' << summary.max << '\n';
+        }
+    }
+    return true;
+}
+
+bool FrameProfiler::WriteJson(const std::filesystem::path& file_path) const
+{
+    std::ofstream file{file_path};
+    if (!file) {
+        std::cout << "Failed to write " << file_path.string() << std::endl;
+        return false;
+    }
+    file << "{\n";
+    bool first_source = true;
+    for (const char* source : {"cpu", "gpu"}) {
+        const auto& samples = source[0] == 'c' ? cpu_samples_ : gpu_samples_;
+        file << (first_source ? "" : ",\n") << "  \"" << source << "\": {\n";
+        for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+            Summary summary = Summarize(samples[slot]);
+            file << "    \"" << SlotName(slot) << "\": {\"samples\": " << summary.samples << ", \"mean_ms\": " << summary.mean
+                << ", \"p50_ms\": " << summary.p50 << ", \"p95_ms\": " << summary.p95 << ", \"p99_ms\": " << summary.p99
+                << ", \"max_ms\": " << summary.max << "}" << (slot + 1 < SLOT_COUNT ? "," : "") << "\n";
+        }
+        file << "  }";
+        first_source = false;
+    }
+    file << "\n}\n";
+    return true;
+}
+
+ScopedPhase::ScopedPhase(FrameProfiler& profiler, FramePhase phase)
+    : profiler_(profiler), phase_(phase)
+{
+    profiler_.BeginPhase(phase_);
+}
+
+ScopedPhase::~ScopedPhase()
+{
+    profiler_.EndPhase(phase_);
+}
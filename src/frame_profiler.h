@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+enum class FramePhase : uint32_t
+{
+    INPUT,
+    CULL,
+    MATRIX_BUILD,
+    UNIFORM_UPLOAD,
+    DRAW_SUBMIT,
+    SWAP,
+    COUNT
+};
+
+inline constexpr uint32_t FRAME_PHASE_COUNT = static_cast<uint32_t>(FramePhase::COUNT);
+
+// Per-phase CPU and GPU frame timing. CPU time comes from steady_clock; GPU time from
+// GL_TIMESTAMP queries issued at every phase boundary. Query sets are kept in a ring and read
+// back QUERY_LATENCY frames later, and only when already available, so the pipeline never stalls.
+class FrameProfiler
+{
+public:
+    FrameProfiler();
+    ~FrameProfiler();
+
+public:
+    void BeginFrame();
+    void EndFrame();
+    void BeginPhase(FramePhase phase);
+    void EndPhase(FramePhase phase);
+
+    void PrintReport() const;
+    bool WriteCsv(const std::filesystem::path& file_path) const;
+    bool WriteJson(const std::filesystem::path& file_path) const;
+
+private:
+    struct Summary
+    {
+        size_t samples;
+        float mean;
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+
+    static constexpr uint32_t QUERY_LATENCY = 4;
+    // one (begin, end) timestamp pair per phase plus one for the whole frame
+    static constexpr uint32_t SLOT_COUNT = FRAME_PHASE_COUNT + 1;
+
+    struct GpuFrame
+    {
+        std::array<uint32_t, SLOT_COUNT * 2> queries;
+        std::array<bool, SLOT_COUNT> issued;
+        bool pending;
+    };
+
+    void CollectGpuFrame(GpuFrame& frame);
+    static Summary Summarize(std::vector<float> samples);
+    static const char* SlotName(uint32_t slot);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::array<GpuFrame, QUERY_LATENCY> gpu_frames_;
+    uint32_t gpu_frame_index_;
+    uint64_t gpu_frames_dropped_;
+    Clock::time_point frame_start_;
+    std::array<Clock::time_point, FRAME_PHASE_COUNT> phase_start_;
+    std::array<float, FRAME_PHASE_COUNT> phase_ms_;
+    std::array<bool, FRAME_PHASE_COUNT> phase_used_;
+    std::array<std::vector<float>, SLOT_COUNT> cpu_samples_;
+    std::array<std::vector<float>, SLOT_COUNT> gpu_samples_;
+};
+
+class ScopedPhase
+{
+public:
+    ScopedPhase(FrameProfiler& profiler, FramePhase phase);
+    ~ScopedPhase();
+
+private:
+    FrameProfiler& profiler_;
+    FramePhase phase_;
+};
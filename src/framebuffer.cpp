@@ -0,0 +1,41 @@
+#include "framebuffer.h"
+
+#include <glad/glad.h>
+
+Framebuffer::Framebuffer(int32_t width, int32_t height)
+    : fbo_id_(0), color_id_(0), depth_id_(0)
+{
+    glGenRenderbuffers(1, &color_id_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_id_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depth_id_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_id_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo_id_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_id_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_id_);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer()
+{
+    glDeleteFramebuffers(1, &fbo_id_);
+    glDeleteRenderbuffers(1, &color_id_);
+    glDeleteRenderbuffers(1, &depth_id_);
+}
+
+void Framebuffer::Bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+}
+
+bool Framebuffer::IsComplete() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// Offscreen render target with an RGBA8 color and a 24/8 depth-stencil renderbuffer.
+class Framebuffer
+{
+public:
+    Framebuffer(int32_t width, int32_t height);
+    ~Framebuffer();
+
+public:
+    void Bind() const;
+    bool IsComplete() const;
+
+private:
+    uint32_t fbo_id_;
+    uint32_t color_id_;
+    uint32_t depth_id_;
+};
@@ -0,0 +1,132 @@
+#include "frustum_culler.h"
+#include "transform_system.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#endif
+
+static size_t cull_scalar(const Frustum& frustum, const TransformStreams& streams, const float* radii, size_t begin,
+    uint32_t* out, size_t visible)
+{
+    for (size_t i = begin; i < streams.count; ++i) {
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.planes) {
+            float distance = plane.x * streams.position[0][i] + plane.y * streams.position[1][i] + plane.z * streams.position[2][i] + plane.w;
+            inside = inside && distance >= -radii[i];
+        }
+        out[visible] = static_cast<uint32_t>(i);
+        visible += inside ? 1 : 0;
+    }
+    return visible;
+}
+
+#if defined(SIMD_X86)
+// branchless compaction: every lane writes its index, only inside lanes advance the cursor
+static inline size_t append_lanes(uint32_t mask, uint32_t lanes, size_t base, uint32_t* out, size_t visible)
+{
+    for (uint32_t lane = 0; lane < lanes; ++lane) {
+        out[visible] = static_cast<uint32_t>(base + lane);
+        visible += (mask >> lane) & 1;
+    }
+    return visible;
+}
+
+static size_t cull_sse(const Frustum& frustum, const TransformStreams& streams, const float* radii, uint32_t* out, size_t* visible)
+{
+    __m128 planes[Frustum::PLANE_COUNT][4];
+    for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        planes[p][0] = _mm_set1_ps(frustum.planes[p].x);
+        planes[p][1] = _mm_set1_ps(frustum.planes[p].y);
+        planes[p][2] = _mm_set1_ps(frustum.planes[p].z);
+        planes[p][3] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    size_t batched = streams.count & ~size_t{3};
+    for (size_t i = 0; i < batched; i += 4) {
+        __m128 x = _mm_load_ps(streams.position[0] + i);
+        __m128 y = _mm_load_ps(streams.position[1] + i);
+        __m128 z = _mm_load_ps(streams.position[2] + i);
+        __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(radii + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+                _mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+        }
+        *visible = append_lanes(static_cast<uint32_t>(_mm_movemask_ps(inside)), 4, i, out, *visible);
+    }
+    return batched;
+}
+
+SIMD_TARGET_AVX2 static size_t cull_avx2(const Frustum& frustum, const TransformStreams& streams, const float* radii, uint32_t* out,
+    size_t* visible)
+{
+    __m256 planes[Frustum::PLANE_COUNT][4];
+    for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        planes[p][0] = _mm256_set1_ps(frustum.planes[p].x);
+        planes[p][1] = _mm256_set1_ps(frustum.planes[p].y);
+        planes[p][2] = _mm256_set1_ps(frustum.planes[p].z);
+        planes[p][3] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+    size_t batched = streams.count & ~size_t{7};
+    for (size_t i = 0; i < batched; i += 8) {
+        __m256 x = _mm256_load_ps(streams.position[0] + i);
+        __m256 y = _mm256_load_ps(streams.position[1] + i);
+        __m256 z = _mm256_load_ps(streams.position[2] + i);
+        __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(radii + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m256 distance = _mm256_fmadd_ps(planes[p][0], x, _mm256_fmadd_ps(planes[p][1], y, _mm256_fmadd_ps(planes[p][2], z, planes[p][3])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, neg_radius, _CMP_GE_OQ));
+        }
+        *visible = append_lanes(static_cast<uint32_t>(_mm256_movemask_ps(inside)), 8, i, out, *visible);
+    }
+    return batched;
+}
+#endif
+
+void FrustumCuller::Resize(size_t count, float radius)
+{
+    radii_.assign(count, radius);
+}
+
+void FrustumCuller::SetRadius(uint32_t index, float radius)
+{
+    radii_[index] = radius;
+}
+
+size_t FrustumCuller::Cull(const Frustum& frustum, const TransformSystem& transforms, std::vector<uint32_t>& visible)
+{
+    TransformStreams streams = transforms.GetStreams();
+    streams.count = std::min(streams.count, radii_.size());
+    // the write cursor never overtakes the object being tested, so the compaction stays in bounds
+    visible.resize(streams.count);
+    size_t visible_count = 0;
+    size_t done = 0;
+#if defined(SIMD_X86)
+    if (GetCPUFeatures().avx2 && GetCPUFeatures().fma) {
+        done = cull_avx2(frustum, streams, radii_.data(), visible.data(), &visible_count);
+    } else {
+        done = cull_sse(frustum, streams, radii_.data(), visible.data(), &visible_count);
+    }
+#endif
+    visible_count = cull_scalar(frustum, streams, radii_.data(), done, visible.data(), visible_count);
+    visible.resize(visible_count);
+
+    last_frame_ = Stats{static_cast<uint32_t>(visible_count), static_cast<uint32_t>(streams.count)};
+    visible_sum_ += visible_count;
+    total_sum_ += streams.count;
+    return visible_count;
+}
+
+const FrustumCuller::Stats& FrustumCuller::GetLastFrame() const
+{
+    return last_frame_;
+}
+
+double FrustumCuller::GetAverageVisibleRatio() const
+{
+    return total_sum_ ? static_cast<double>(visible_sum_) / static_cast<double>(total_sum_) : 0.0;
+}
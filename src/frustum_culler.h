@@ -0,0 +1,40 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "camera.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class TransformSystem;
+
+// Bounding sphere test against the 6 frustum planes, 8 (AVX2) or 4 (SSE) objects per step.
+// Sphere centres are read straight from the TransformSystem position streams; the culler
+// only owns the radii. Survivors come out as a dense, ascending index list.
+class FrustumCuller
+{
+public:
+    struct Stats
+    {
+        uint32_t visible;
+        uint32_t total;
+    };
+
+public:
+    void Resize(size_t count, float radius);
+    void SetRadius(uint32_t index, float radius);
+
+    // returns the number of visible objects; visible is resized to match
+    size_t Cull(const Frustum& frustum, const TransformSystem& transforms, std::vector<uint32_t>& visible);
+
+    const Stats& GetLastFrame() const;
+    // visible fraction averaged over every Cull call so far
+    double GetAverageVisibleRatio() const;
+
+private:
+    std::vector<float, AlignedAllocator<float, 32>> radii_;
+    Stats last_frame_{};
+    uint64_t visible_sum_ = 0;
+    uint64_t total_sum_ = 0;
+};
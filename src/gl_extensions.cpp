@@ -0,0 +1,105 @@
+#include "gl_extensions.h"
+
+#include <iostream>
+
+PFNGLMULTIDRAWARRAYSINDIRECTPROC ext_glMultiDrawArraysIndirect = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC ext_glMultiDrawElementsIndirect = nullptr;
+PFNGLBUFFERSTORAGEPROC ext_glBufferStorage = nullptr;
+PFNGLGETPROGRAMBINARYPROC ext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC ext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC ext_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ext_glMaxShaderCompilerThreadsKHR = nullptr;
+PFNGLSHADERBINARYPROC ext_glShaderBinary = nullptr;
+PFNGLSPECIALIZESHADERARBPROC ext_glSpecializeShaderARB = nullptr;
+PFNGLGETPROGRAMRESOURCEIVPROC ext_glGetProgramResourceiv = nullptr;
+PFNGLCOPYIMAGESUBDATAPROC ext_glCopyImageSubData = nullptr;
+PFNGLGETTEXTUREHANDLEARBPROC ext_glGetTextureHandleARB = nullptr;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC ext_glMakeTextureHandleResidentARB = nullptr;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC ext_glMakeTextureHandleNonResidentARB = nullptr;
+
+GLCapabilities gl_capabilities{};
+
+template<typename T>
+static T load_proc(GLADloadproc load, const char* name)
+{
+    return reinterpret_cast<T>(load(name));
+}
+
+void LoadGLExtensions(GLADloadproc load)
+{
+    gl_capabilities = GLCapabilities{};
+    gl_capabilities.version_major = GLVersion.major;
+    gl_capabilities.version_minor = GLVersion.minor;
+
+    ext_glMultiDrawArraysIndirect = load_proc<PFNGLMULTIDRAWARRAYSINDIRECTPROC>(load, "glMultiDrawArraysIndirect");
+    ext_glMultiDrawElementsIndirect = load_proc<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(load, "glMultiDrawElementsIndirect");
+    ext_glBufferStorage = load_proc<PFNGLBUFFERSTORAGEPROC>(load, "glBufferStorage");
+    ext_glGetProgramBinary = load_proc<PFNGLGETPROGRAMBINARYPROC>(load, "glGetProgramBinary");
+    ext_glProgramBinary = load_proc<PFNGLPROGRAMBINARYPROC>(load, "glProgramBinary");
+    ext_glProgramParameteri = load_proc<PFNGLPROGRAMPARAMETERIPROC>(load, "glProgramParameteri");
+    ext_glMaxShaderCompilerThreadsKHR = load_proc<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load, "glMaxShaderCompilerThreadsKHR");
+    if (!glMaxShaderCompilerThreadsKHR) {
+        ext_glMaxShaderCompilerThreadsKHR = load_proc<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load, "glMaxShaderCompilerThreadsARB");
+    }
+    ext_glShaderBinary = load_proc<PFNGLSHADERBINARYPROC>(load, "glShaderBinary");
+    ext_glSpecializeShaderARB = load_proc<PFNGLSPECIALIZESHADERARBPROC>(load, "glSpecializeShaderARB");
+    if (!glSpecializeShaderARB) {
+        ext_glSpecializeShaderARB = load_proc<PFNGLSPECIALIZESHADERARBPROC>(load, "glSpecializeShader");
+    }
+    ext_glGetProgramResourceiv = load_proc<PFNGLGETPROGRAMRESOURCEIVPROC>(load, "glGetProgramResourceiv");
+    ext_glCopyImageSubData = load_proc<PFNGLCOPYIMAGESUBDATAPROC>(load, "glCopyImageSubData");
+    ext_glGetTextureHandleARB = load_proc<PFNGLGETTEXTUREHANDLEARBPROC>(load, "glGetTextureHandleARB");
+    ext_glMakeTextureHandleResidentARB = load_proc<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(load, "glMakeTextureHandleResidentARB");
+    ext_glMakeTextureHandleNonResidentARB = load_proc<PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC>(load, "glMakeTextureHandleNonResidentARB");
+
+    // a core 4.3 context only: assets/shaders/indirect.vert is #version 430, so the extensions alone
+    // on an older context would pass here and then fail to compile
+    gl_capabilities.multi_draw_indirect = HasGLVersion(4, 3) && glMultiDrawElementsIndirect;
+    gl_capabilities.shader_draw_parameters = HasGLVersion(4, 6) || HasGLExtension("GL_ARB_shader_draw_parameters");
+    gl_capabilities.buffer_storage = (HasGLVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage")) && glBufferStorage;
+    if ((HasGLVersion(4, 1) || HasGLExtension("GL_ARB_get_program_binary")) && glGetProgramBinary && glProgramBinary &&
+        glProgramParameteri) {
+        int32_t format_count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        gl_capabilities.program_binary = format_count > 0;
+    }
+    gl_capabilities.parallel_shader_compile = HasGLExtension("GL_KHR_parallel_shader_compile") ||
+        HasGLExtension("GL_ARB_parallel_shader_compile");
+    gl_capabilities.gl_spirv = (HasGLVersion(4, 6) || HasGLExtension("GL_ARB_gl_spirv")) && glShaderBinary &&
+        glSpecializeShaderARB && glGetProgramResourceiv;
+    gl_capabilities.texture_compression_s3tc = HasGLExtension("GL_EXT_texture_compression_s3tc");
+    gl_capabilities.texture_compression_s3tc_srgb = gl_capabilities.texture_compression_s3tc &&
+        (HasGLExtension("GL_EXT_texture_sRGB") || HasGLExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    gl_capabilities.texture_compression_bptc = HasGLVersion(4, 2) || HasGLExtension("GL_ARB_texture_compression_bptc");
+    gl_capabilities.copy_image = (HasGLVersion(4, 3) || HasGLExtension("GL_ARB_copy_image")) && glCopyImageSubData;
+    // the extension's GLSL side needs #version 400
+    gl_capabilities.bindless_texture = HasGLExtension("GL_ARB_bindless_texture") && HasGLVersion(4, 0) &&
+        (HasGLVersion(4, 3) || HasGLExtension("GL_ARB_shader_storage_buffer_object")) && glGetTextureHandleARB &&
+        glMakeTextureHandleResidentARB && glMakeTextureHandleNonResidentARB;
+    gl_capabilities.gpu_shader5_nv = HasGLExtension("GL_NV_gpu_shader5");
+    if (gl_capabilities.parallel_shader_compile && glMaxShaderCompilerThreadsKHR) {
+        // let the driver pick as many compiler threads as it likes
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+}
+
+bool HasGLVersion(int32_t major, int32_t minor)
+{
+    return gl_capabilities.version_major > major ||
+        (gl_capabilities.version_major == major && gl_capabilities.version_minor >= minor);
+}
+
+bool HasGLExtension(std::string_view name)
+{
+    int32_t count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int32_t i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && name == extension) {
+            return true;
+        }
+    }
+    return false;
+}
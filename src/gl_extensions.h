@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <string_view>
+
+// glad is generated for the plain GL 3.3 core profile. Everything newer is declared here
+// and loaded at runtime; the pointers stay null when the context doesn't provide them.
+
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#define GL_SHADER_BINARY_FORMAT_SPIR_V_ARB 0x9551
+#define GL_UNIFORM 0x92E1
+#define GL_LOCATION 0x930E
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+
+typedef void (APIENTRYP PFNGLMULTIDRAWARRAYSINDIRECTPROC)(GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLSHADERBINARYPROC)(GLsizei count, const GLuint* shaders, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLSPECIALIZESHADERARBPROC)(GLuint shader, const GLchar* entry_point, GLuint constant_count,
+    const GLuint* constant_index, const GLuint* constant_value);
+typedef void (APIENTRYP PFNGLGETPROGRAMRESOURCEIVPROC)(GLuint program, GLenum interface, GLuint index, GLsizei prop_count,
+    const GLenum* props, GLsizei count, GLsizei* length, GLint* params);
+typedef void (APIENTRYP PFNGLCOPYIMAGESUBDATAPROC)(GLuint src_name, GLenum src_target, GLint src_level, GLint src_x, GLint src_y,
+    GLint src_z, GLuint dst_name, GLenum dst_target, GLint dst_level, GLint dst_x, GLint dst_y, GLint dst_z, GLsizei width,
+    GLsizei height, GLsizei depth);
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+extern PFNGLMULTIDRAWARRAYSINDIRECTPROC ext_glMultiDrawArraysIndirect;
+#define glMultiDrawArraysIndirect ext_glMultiDrawArraysIndirect
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC ext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect ext_glMultiDrawElementsIndirect
+extern PFNGLBUFFERSTORAGEPROC ext_glBufferStorage;
+#define glBufferStorage ext_glBufferStorage
+extern PFNGLGETPROGRAMBINARYPROC ext_glGetProgramBinary;
+#define glGetProgramBinary ext_glGetProgramBinary
+extern PFNGLPROGRAMBINARYPROC ext_glProgramBinary;
+#define glProgramBinary ext_glProgramBinary
+extern PFNGLPROGRAMPARAMETERIPROC ext_glProgramParameteri;
+#define glProgramParameteri ext_glProgramParameteri
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR ext_glMaxShaderCompilerThreadsKHR
+extern PFNGLSHADERBINARYPROC ext_glShaderBinary;
+#define glShaderBinary ext_glShaderBinary
+extern PFNGLSPECIALIZESHADERARBPROC ext_glSpecializeShaderARB;
+#define glSpecializeShaderARB ext_glSpecializeShaderARB
+extern PFNGLGETPROGRAMRESOURCEIVPROC ext_glGetProgramResourceiv;
+#define glGetProgramResourceiv ext_glGetProgramResourceiv
+extern PFNGLCOPYIMAGESUBDATAPROC ext_glCopyImageSubData;
+#define glCopyImageSubData ext_glCopyImageSubData
+extern PFNGLGETTEXTUREHANDLEARBPROC ext_glGetTextureHandleARB;
+#define glGetTextureHandleARB ext_glGetTextureHandleARB
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC ext_glMakeTextureHandleResidentARB;
+#define glMakeTextureHandleResidentARB ext_glMakeTextureHandleResidentARB
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC ext_glMakeTextureHandleNonResidentARB;
+#define glMakeTextureHandleNonResidentARB ext_glMakeTextureHandleNonResidentARB
+
+struct GLCapabilities
+{
+    int32_t version_major = 0;
+    int32_t version_minor = 0;
+    // GL 4.3 (multi draw indirect and SSBOs in a #version 430 shader)
+    bool multi_draw_indirect = false;
+    // GL 4.6 / ARB_shader_draw_parameters (gl_DrawID, gl_BaseInstance)
+    bool shader_draw_parameters = false;
+    // GL 4.4 / ARB_buffer_storage (persistent mapping)
+    bool buffer_storage = false;
+    // GL 4.1 / ARB_get_program_binary, with at least one binary format on offer
+    bool program_binary = false;
+    // KHR/ARB_parallel_shader_compile (GL_COMPLETION_STATUS_KHR can be polled without blocking)
+    bool parallel_shader_compile = false;
+    // GL 4.6 / ARB_gl_spirv, plus the GL 4.3 resource queries needed to find uniforms without names
+    bool gl_spirv = false;
+    // EXT_texture_compression_s3tc (BC1-BC3); the sRGB variants need EXT_texture_sRGB on top
+    bool texture_compression_s3tc = false;
+    bool texture_compression_s3tc_srgb = false;
+    // GL 4.2 / ARB_texture_compression_bptc (BC6H, BC7)
+    bool texture_compression_bptc = false;
+    // GL 4.3 / ARB_copy_image (texel copies between textures without a round trip through a buffer)
+    bool copy_image = false;
+    // ARB_bindless_texture (64-bit texture handles sampled without texture units) with GLSL 4.00, plus SSBOs to keep them in
+    bool bindless_texture = false;
+    // NV_gpu_shader5 (among others: sampling through handles that differ between invocations of a draw)
+    bool gpu_shader5_nv = false;
+};
+
+extern GLCapabilities gl_capabilities;
+
+// must be called with the context current, right after gladLoadGLLoader
+void LoadGLExtensions(GLADloadproc load);
+bool HasGLVersion(int32_t major, int32_t minor);
+bool HasGLExtension(std::string_view name);
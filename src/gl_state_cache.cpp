@@ -0,0 +1,222 @@
+#include "gl_state_cache.h"
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+GLStateCache gl_state{};
+
+static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+static int32_t texture_target_index(uint32_t target)
+{
+    switch (target) {
+    case GL_TEXTURE_2D:
+        return 0;
+    case GL_TEXTURE_2D_ARRAY:
+        return 1;
+    case GL_TEXTURE_CUBE_MAP:
+        return 2;
+    case GL_TEXTURE_3D:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+static const char* counter_name(GLStateCache::Counter counter)
+{
+    switch (counter) {
+    case GLStateCache::Counter::PROGRAM:
+        return "glUseProgram";
+    case GLStateCache::Counter::VERTEX_ARRAY:
+        return "glBindVertexArray";
+    case GLStateCache::Counter::ACTIVE_TEXTURE:
+        return "glActiveTexture";
+    case GLStateCache::Counter::TEXTURE:
+        return "glBindTexture";
+    case GLStateCache::Counter::CAPABILITY:
+        return "glEnable/glDisable";
+    case GLStateCache::Counter::BLEND_FUNC:
+        return "glBlendFunc";
+    case GLStateCache::Counter::DEPTH_FUNC:
+        return "glDepthFunc";
+    case GLStateCache::Counter::POLYGON_MODE:
+        return "glPolygonMode";
+    default:
+        return "?";
+    }
+}
+
+GLStateCache::GLStateCache()
+    : counts_{}
+{
+    Invalidate();
+}
+
+void GLStateCache::UseProgram(uint32_t program)
+{
+    if (Update(program_, program, Counter::PROGRAM)) {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::BindVertexArray(uint32_t vao)
+{
+    if (Update(vao_, vao, Counter::VERTEX_ARRAY)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void GLStateCache::BindTexture(uint32_t unit, uint32_t target, uint32_t texture)
+{
+    int32_t target_index = texture_target_index(target);
+    if (unit >= MAX_TEXTURE_UNITS || target_index < 0) {
+        ActiveTexture(unit);
+        ++counts_[static_cast<size_t>(Counter::TEXTURE)].issued;
+        glBindTexture(target, texture);
+        return;
+    }
+    uint32_t& shadow = textures_[unit][static_cast<size_t>(target_index)];
+    if (shadow == texture) {
+        ++counts_[static_cast<size_t>(Counter::TEXTURE)].filtered;
+        return;
+    }
+    ActiveTexture(unit);
+    Update(shadow, texture, Counter::TEXTURE);
+    glBindTexture(target, texture);
+}
+
+void GLStateCache::SetEnabled(uint32_t capability, bool enabled)
+{
+    uint32_t* shadow = capability == GL_BLEND ? &blend_ : capability == GL_DEPTH_TEST ? &depth_test_ : nullptr;
+    if (shadow && !Update(*shadow, enabled ? 1 : 0, Counter::CAPABILITY)) {
+        return;
+    }
+    if (!shadow) {
+        ++counts_[static_cast<size_t>(Counter::CAPABILITY)].issued;
+    }
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GLStateCache::BlendFunc(uint32_t src_factor, uint32_t dst_factor)
+{
+    if (blend_src_ == src_factor && blend_dst_ == dst_factor) {
+        ++counts_[static_cast<size_t>(Counter::BLEND_FUNC)].filtered;
+        return;
+    }
+    ++counts_[static_cast<size_t>(Counter::BLEND_FUNC)].issued;
+    blend_src_ = src_factor;
+    blend_dst_ = dst_factor;
+    glBlendFunc(src_factor, dst_factor);
+}
+
+void GLStateCache::DepthFunc(uint32_t func)
+{
+    if (Update(depth_func_, func, Counter::DEPTH_FUNC)) {
+        glDepthFunc(func);
+    }
+}
+
+void GLStateCache::PolygonMode(uint32_t mode)
+{
+    if (Update(polygon_mode_, mode, Counter::POLYGON_MODE)) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+}
+
+void GLStateCache::OnProgramDeleted(uint32_t program)
+{
+    // a deleted program stays current until something else is bound, so forget it instead of assuming 0
+    if (program_ == program) {
+        program_ = UNKNOWN;
+    }
+}
+
+void GLStateCache::OnVertexArrayDeleted(uint32_t vao)
+{
+    if (vao_ == vao) {
+        vao_ = 0;
+    }
+}
+
+void GLStateCache::OnTextureDeleted(uint32_t texture)
+{
+    for (auto& unit : textures_) {
+        for (uint32_t& bound : unit) {
+            if (bound == texture) {
+                bound = 0;
+            }
+        }
+    }
+}
+
+void GLStateCache::Invalidate()
+{
+    program_ = UNKNOWN;
+    vao_ = UNKNOWN;
+    active_unit_ = UNKNOWN;
+    for (auto& unit : textures_) {
+        unit.fill(UNKNOWN);
+    }
+    blend_ = UNKNOWN;
+    depth_test_ = UNKNOWN;
+    blend_src_ = UNKNOWN;
+    blend_dst_ = UNKNOWN;
+    depth_func_ = UNKNOWN;
+    polygon_mode_ = UNKNOWN;
+}
+
+const GLStateCache::CallCounts& GLStateCache::GetCounts(Counter counter) const
+{
+    return counts_[static_cast<size_t>(counter)];
+}
+
+void GLStateCache::ResetCounts()
+{
+    counts_ = {};
+}
+
+void GLStateCache::PrintStats() const
+{
+    uint64_t total_issued = 0;
+    uint64_t total_filtered = 0;
+    std::cout << "GL state cache:" << std::endl;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        const CallCounts& counts = counts_[i];
+        if (counts.issued + counts.filtered == 0) {
+            continue;
+        }
+        std::cout << "  " << counter_name(static_cast<Counter>(i)) << ": " << counts.issued << " issued, " << counts.filtered
+                  << " filtered" << std::endl;
+        total_issued += counts.issued;
+        total_filtered += counts.filtered;
+    }
+    double filtered_ratio = total_issued + total_filtered ? 100.0 * static_cast<double>(total_filtered) /
+        static_cast<double>(total_issued + total_filtered) : 0.0;
+    std::cout << "  total: " << total_issued << " issued, " << total_filtered << " filtered (" << filtered_ratio << "%)"
+              << std::endl;
+}
+
+bool GLStateCache::Update(uint32_t& shadow, uint32_t value, Counter counter)
+{
+    CallCounts& counts = counts_[static_cast<size_t>(counter)];
+    if (shadow == value) {
+        ++counts.filtered;
+        return false;
+    }
+    ++counts.issued;
+    shadow = value;
+    return true;
+}
+
+void GLStateCache::ActiveTexture(uint32_t unit)
+{
+    if (Update(active_unit_, unit, Counter::ACTIVE_TEXTURE)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+// Shadows the bits of GL state the renderer touches every frame and drops calls that would
+// set a value that is already current. The shadow starts out unknown, so the first call for
+// each piece of state always reaches GL; Invalidate() returns to that after a context switch
+// or after code outside the cache has changed state behind its back.
+class GLStateCache
+{
+public:
+    enum class Counter : uint32_t
+    {
+        PROGRAM,
+        VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        CAPABILITY,
+        BLEND_FUNC,
+        DEPTH_FUNC,
+        POLYGON_MODE,
+        COUNT
+    };
+
+    struct CallCounts
+    {
+        uint64_t issued;
+        uint64_t filtered;
+    };
+
+    static constexpr uint32_t MAX_TEXTURE_UNITS = 16;
+
+public:
+    GLStateCache();
+
+public:
+    void UseProgram(uint32_t program);
+    void BindVertexArray(uint32_t vao);
+    void BindTexture(uint32_t unit, uint32_t target, uint32_t texture);
+    // only GL_BLEND and GL_DEPTH_TEST are shadowed, other capabilities go straight to GL
+    void SetEnabled(uint32_t capability, bool enabled);
+    void BlendFunc(uint32_t src_factor, uint32_t dst_factor);
+    void DepthFunc(uint32_t func);
+    void PolygonMode(uint32_t mode);
+
+    // deleting a bound object makes GL fall back to 0, and the name may be handed out again
+    void OnProgramDeleted(uint32_t program);
+    void OnVertexArrayDeleted(uint32_t vao);
+    void OnTextureDeleted(uint32_t texture);
+
+    void Invalidate();
+    const CallCounts& GetCounts(Counter counter) const;
+    void ResetCounts();
+    void PrintStats() const;
+
+private:
+    bool Update(uint32_t& shadow, uint32_t value, Counter counter);
+    void ActiveTexture(uint32_t unit);
+
+private:
+    static constexpr uint32_t TEXTURE_TARGETS = 4;
+
+    uint32_t program_;
+    uint32_t vao_;
+    uint32_t active_unit_;
+    std::array<std::array<uint32_t, TEXTURE_TARGETS>, MAX_TEXTURE_UNITS> textures_;
+    uint32_t blend_;
+    uint32_t depth_test_;
+    uint32_t blend_src_;
+    uint32_t blend_dst_;
+    uint32_t depth_func_;
+    uint32_t polygon_mode_;
+    std::array<CallCounts, static_cast<size_t>(Counter::COUNT)> counts_;
+};
+
+extern GLStateCache gl_state;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <string_view>
+
+inline constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+inline constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+// 64-bit FNV-1a; constexpr so names can be hashed at compile time. Chain calls by passing
+// the previous result as the seed.
+constexpr uint64_t Fnv1a64(std::string_view data, uint64_t seed = FNV1A_OFFSET_BASIS)
+{
+    uint64_t hash = seed;
+    for (char c : data) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
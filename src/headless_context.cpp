@@ -0,0 +1,138 @@
+#include "headless_context.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+
+static bool has_egl_extension(const char* extensions, const char* name)
+{
+    if (!extensions) {
+        return false;
+    }
+    size_t length = std::strlen(name);
+    for (const char* it = std::strstr(extensions, name); it; it = std::strstr(it + length, name)) {
+        if ((it == extensions || it[-1] == ' ') && (it[length] == ' ' || it[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HeadlessContext::HeadlessContext()
+    : display_(nullptr), context_(nullptr)
+{
+
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    EGLDisplay display = static_cast<EGLDisplay>(display_);
+    if (context_) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, static_cast<EGLContext>(context_));
+    }
+    if (display_) {
+        eglTerminate(display);
+    }
+}
+
+bool HeadlessContext::Create(int32_t major, int32_t minor)
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display && has_egl_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    } else {
+        std::cout << "EGL_MESA_platform_surfaceless is unavailable, trying the default EGL display" << std::endl;
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cout << "Failed to initialize EGL display (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return false;
+    }
+    display_ = display;
+
+    const char* display_extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!has_egl_extension(display_extensions, "EGL_KHR_surfaceless_context")) {
+        std::cout << "EGL_KHR_surfaceless_context is not supported" << std::endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "EGL has no desktop OpenGL support" << std::endl;
+        return false;
+    }
+
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (!has_egl_extension(display_extensions, "EGL_KHR_no_config_context")) {
+        const EGLint config_attribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_NONE
+        };
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count == 0) {
+            std::cout << "No EGL config with desktop OpenGL support" << std::endl;
+            return false;
+        }
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cout << "Failed to create OpenGL " << major << "." << minor << " core context (error 0x" << std::hex << eglGetError()
+            << std::dec << ")" << std::endl;
+        return false;
+    }
+    context_ = context;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cout << "Failed to make the headless context current" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+HeadlessContext::HeadlessContext()
+    : display_(nullptr), context_(nullptr)
+{
+
+}
+
+HeadlessContext::~HeadlessContext()
+{
+
+}
+
+bool HeadlessContext::Create(int32_t major, int32_t minor)
+{
+    (void)major;
+    (void)minor;
+    std::cout << "Headless mode is only supported on Linux (EGL)" << std::endl;
+    return false;
+}
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+    (void)name;
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+// Window-less GL core context for machines without a display or GPU. On Linux it uses EGL on
+// Mesa's surfaceless platform (EGL_MESA_platform_surfaceless), which runs on llvmpipe; there is
+// no default framebuffer, so everything must be rendered into an FBO.
+class HeadlessContext
+{
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+public:
+    bool Create(int32_t major, int32_t minor);
+    static void* GetProcAddress(const char* name);
+
+private:
+    void* display_;
+    void* context_;
+};
@@ -0,0 +1,132 @@
+#include "indirect_renderer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+IndirectRenderer::IndirectRenderer()
+    : vao_(0), vbo_(0), ebo_(0), ssbo_alignment_(256), meshes_dirty_(false), ring_buffer_id_(0), command_allocation_{}, command_count_(0)
+{
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssbo_alignment_);
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ebo_);
+
+    gl_state.BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), reinterpret_cast<void*>(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    gl_state.BindVertexArray(0);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    gl_state.OnVertexArrayDeleted(vao_);
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &vbo_);
+    glDeleteBuffers(1, &ebo_);
+}
+
+bool IndirectRenderer::IsSupported()
+{
+    return gl_capabilities.multi_draw_indirect && gl_capabilities.shader_draw_parameters;
+}
+
+uint32_t IndirectRenderer::AddMesh(const MeshData& mesh)
+{
+    MeshRange range{};
+    range.index_count = static_cast<uint32_t>(mesh.indices.size());
+    range.first_index = static_cast<uint32_t>(indices_.size());
+    range.base_vertex = static_cast<int32_t>(vertices_.size() / VERTEX_FLOATS);
+    vertices_.insert(vertices_.end(), mesh.vertices.begin(), mesh.vertices.end());
+    indices_.insert(indices_.end(), mesh.indices.begin(), mesh.indices.end());
+    meshes_.push_back(range);
+    instances_.emplace_back();
+    materials_.emplace_back();
+    meshes_dirty_ = true;
+    return static_cast<uint32_t>(meshes_.size() - 1);
+}
+
+void IndirectRenderer::Submit(uint32_t mesh_id, const glm::mat4& model, uint32_t material)
+{
+    instances_[mesh_id].push_back(model);
+    materials_[mesh_id].push_back(material);
+}
+
+void IndirectRenderer::Prepare(DynamicRingBuffer& ring)
+{
+    if (meshes_dirty_) {
+        UploadMeshes();
+    }
+
+    size_t instance_count = 0;
+    command_count_ = 0;
+    for (const std::vector<glm::mat4>& models : instances_) {
+        instance_count += models.size();
+        command_count_ += models.empty() ? 0 : 1;
+    }
+    ring_buffer_id_ = ring.GetBufferId();
+    if (command_count_ == 0) {
+        return;
+    }
+
+    // one command per mesh; its instances are packed contiguously starting at base_instance
+    RingAllocation instance_allocation = ring.Allocate(instance_count * sizeof(glm::mat4), static_cast<size_t>(ssbo_alignment_));
+    RingAllocation material_allocation = ring.Allocate(instance_count * sizeof(uint32_t), static_cast<size_t>(ssbo_alignment_));
+    command_allocation_ = ring.Allocate(command_count_ * sizeof(DrawElementsIndirectCommand), sizeof(uint32_t));
+    auto* instance_data = static_cast<glm::mat4*>(instance_allocation.data);
+    auto* material_data = static_cast<uint32_t*>(material_allocation.data);
+    auto* commands = static_cast<DrawElementsIndirectCommand*>(command_allocation_.data);
+    uint32_t base_instance = 0;
+    for (size_t mesh_id = 0; mesh_id < meshes_.size(); ++mesh_id) {
+        std::vector<glm::mat4>& models = instances_[mesh_id];
+        if (models.empty()) {
+            continue;
+        }
+        const MeshRange& range = meshes_[mesh_id];
+        DrawElementsIndirectCommand command{};
+        command.count = range.index_count;
+        command.instance_count = static_cast<uint32_t>(models.size());
+        command.first_index = range.first_index;
+        command.base_vertex = range.base_vertex;
+        command.base_instance = base_instance;
+        *commands++ = command;
+        std::memcpy(instance_data + base_instance, models.data(), models.size() * sizeof(glm::mat4));
+        std::memcpy(material_data + base_instance, materials_[mesh_id].data(), models.size() * sizeof(uint32_t));
+        base_instance += command.instance_count;
+        models.clear();
+        materials_[mesh_id].clear();
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, ring_buffer_id_, static_cast<GLintptr>(instance_allocation.offset),
+        static_cast<GLsizeiptr>(instance_allocation.size));
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, ring_buffer_id_, static_cast<GLintptr>(material_allocation.offset),
+        static_cast<GLsizeiptr>(material_allocation.size));
+}
+
+void IndirectRenderer::Draw()
+{
+    if (command_count_ == 0) {
+        return;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring_buffer_id_);
+    gl_state.BindVertexArray(vao_);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<void*>(command_allocation_.offset),
+        static_cast<int32_t>(command_count_), 0);
+}
+
+void IndirectRenderer::UploadMeshes()
+{
+    gl_state.BindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), vertices_.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(uint32_t), indices_.data(), GL_STATIC_DRAW);
+    gl_state.BindVertexArray(0);
+    meshes_dirty_ = false;
+}
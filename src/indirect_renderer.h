@@ -0,0 +1,67 @@
+#pragma once
+
+#include "mesh.h"
+#include "dynamic_ring_buffer.h"
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// layout mandated by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t base_instance;
+};
+
+// Collects every draw of a frame and submits them with a single glMultiDrawElementsIndirect.
+// All meshes live in one shared vertex/index buffer, and each mesh becomes one command whose
+// instances read their model matrix from an SSBO at gl_BaseInstance + gl_InstanceID, and their
+// material index from a second SSBO at the same position.
+// Commands, model matrices and material indices are written straight into the frame's ring buffer region.
+class IndirectRenderer
+{
+public:
+    IndirectRenderer();
+    ~IndirectRenderer();
+
+public:
+    // needs GL 4.3 (multi draw indirect, SSBOs) plus gl_BaseInstance in the vertex shader
+    static bool IsSupported();
+
+    uint32_t AddMesh(const MeshData& mesh);
+    void Submit(uint32_t mesh_id, const glm::mat4& model, uint32_t material = 0);
+    // writes commands and instances into the ring; call before ring.Commit()
+    void Prepare(DynamicRingBuffer& ring);
+    // issues the multi draw prepared earlier; call after ring.Commit()
+    void Draw();
+
+private:
+    void UploadMeshes();
+
+private:
+    struct MeshRange
+    {
+        uint32_t index_count;
+        uint32_t first_index;
+        int32_t base_vertex;
+    };
+
+    uint32_t vao_;
+    uint32_t vbo_;
+    uint32_t ebo_;
+    int32_t ssbo_alignment_;
+    bool meshes_dirty_;
+    uint32_t ring_buffer_id_;
+    RingAllocation command_allocation_;
+    std::vector<float> vertices_;
+    std::vector<uint32_t> indices_;
+    std::vector<MeshRange> meshes_;
+    std::vector<std::vector<glm::mat4>> instances_;
+    std::vector<std::vector<uint32_t>> materials_;
+    uint32_t command_count_;
+};
@@ -0,0 +1,282 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+
+static const uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// identifier, the nine header words, the DFD/KVD/SGD index; the level index follows
+static constexpr size_t KTX2_HEADER_SIZE = 80;
+static constexpr size_t KTX2_LEVEL_ENTRY_SIZE = 24;
+
+// Khronos data format descriptor values for the block-compressed color models
+static constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+static constexpr uint32_t KHR_DF_MODEL_BC3 = 130;
+static constexpr uint32_t KHR_DF_MODEL_BC7 = 134;
+static constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+static constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+static constexpr uint32_t KHR_DF_CHANNEL_COLOR = 0;
+static constexpr uint32_t KHR_DF_CHANNEL_BC3_ALPHA = 15;
+
+uint32_t Ktx2BlockBytes(Ktx2Format format)
+{
+    switch (format) {
+    case Ktx2Format::BC1_RGB_UNORM:
+    case Ktx2Format::BC1_RGB_SRGB:
+        return 8;
+    case Ktx2Format::BC3_UNORM:
+    case Ktx2Format::BC3_SRGB:
+    case Ktx2Format::BC7_UNORM:
+    case Ktx2Format::BC7_SRGB:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+bool Ktx2IsSrgb(Ktx2Format format)
+{
+    return format == Ktx2Format::BC1_RGB_SRGB || format == Ktx2Format::BC3_SRGB || format == Ktx2Format::BC7_SRGB;
+}
+
+const char* Ktx2FormatName(Ktx2Format format)
+{
+    switch (format) {
+    case Ktx2Format::BC1_RGB_UNORM:
+        return "BC1";
+    case Ktx2Format::BC1_RGB_SRGB:
+        return "BC1 sRGB";
+    case Ktx2Format::BC3_UNORM:
+        return "BC3";
+    case Ktx2Format::BC3_SRGB:
+        return "BC3 sRGB";
+    case Ktx2Format::BC7_UNORM:
+        return "BC7";
+    case Ktx2Format::BC7_SRGB:
+        return "BC7 sRGB";
+    default:
+        return "unknown";
+    }
+}
+
+size_t Ktx2LevelSize(Ktx2Format format, uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * Ktx2BlockBytes(format);
+}
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void put_u32(std::vector<uint8_t>& out, size_t offset, uint32_t value)
+{
+    std::memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+static void put_u64(std::vector<uint8_t>& out, size_t offset, uint64_t value)
+{
+    std::memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+static uint32_t get_u32(const std::vector<uint8_t>& in, size_t offset)
+{
+    uint32_t value;
+    std::memcpy(&value, in.data() + offset, sizeof(value));
+    return value;
+}
+
+static uint64_t get_u64(const std::vector<uint8_t>& in, size_t offset)
+{
+    uint64_t value;
+    std::memcpy(&value, in.data() + offset, sizeof(value));
+    return value;
+}
+
+// the basic descriptor block: one 16 byte sample per channel the block format encodes
+static std::vector<uint8_t> build_dfd(Ktx2Format format)
+{
+    struct Sample
+    {
+        uint32_t channel;
+        uint32_t bit_offset;
+        uint32_t bit_length;
+    };
+    uint32_t model = KHR_DF_MODEL_BC7;
+    std::vector<Sample> samples{{KHR_DF_CHANNEL_COLOR, 0, 128}};
+    if (Ktx2BlockBytes(format) == 8) {
+        model = KHR_DF_MODEL_BC1A;
+        samples = {{KHR_DF_CHANNEL_COLOR, 0, 64}};
+    } else if (format == Ktx2Format::BC3_UNORM || format == Ktx2Format::BC3_SRGB) {
+        model = KHR_DF_MODEL_BC3;
+        samples = {{KHR_DF_CHANNEL_BC3_ALPHA, 0, 64}, {KHR_DF_CHANNEL_COLOR, 64, 64}};
+    }
+    uint32_t transfer = Ktx2IsSrgb(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR;
+
+    uint32_t block_size = 24 + 16 * static_cast<uint32_t>(samples.size());
+    std::vector<uint8_t> dfd(4 + block_size, 0);
+    put_u32(dfd, 0, static_cast<uint32_t>(dfd.size()));
+    // vendor 0 (Khronos), descriptor type 0 (basic), version 2
+    put_u32(dfd, 4, 0);
+    put_u32(dfd, 8, 2 | (block_size << 16));
+    put_u32(dfd, 12, model | (KHR_DF_PRIMARIES_BT709 << 8) | (transfer << 16));
+    // texel block dimensions are stored minus one
+    put_u32(dfd, 16, 3 | (3 << 8));
+    put_u32(dfd, 20, Ktx2BlockBytes(format));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        size_t offset = 28 + 16 * i;
+        const Sample& sample = samples[i];
+        put_u32(dfd, offset, sample.bit_offset | ((sample.bit_length - 1) << 16) | (sample.channel << 24));
+        put_u32(dfd, offset + 8, 0);
+        put_u32(dfd, offset + 12, UINT32_MAX);
+    }
+    return dfd;
+}
+
+// key/value entries are length prefixed, padded to 4 bytes and sorted by key
+static std::vector<uint8_t> build_kvd(const Ktx2Texture& texture)
+{
+    const std::pair<std::string, std::string> entries[] = {
+        {"KTXorientation", texture.orientation},
+        {"KTXwriter", "texbake (learn-opengl)"},
+    };
+    std::vector<uint8_t> kvd;
+    for (const auto& [key, value] : entries) {
+        uint32_t length = static_cast<uint32_t>(key.size() + 1 + value.size() + 1);
+        size_t offset = kvd.size();
+        kvd.resize(align_up(offset + 4 + length, 4), 0);
+        put_u32(kvd, offset, length);
+        std::memcpy(kvd.data() + offset + 4, key.c_str(), key.size() + 1);
+        std::memcpy(kvd.data() + offset + 4 + key.size() + 1, value.c_str(), value.size() + 1);
+    }
+    return kvd;
+}
+
+static std::string find_orientation(const std::vector<uint8_t>& file, size_t offset, size_t length)
+{
+    size_t end = offset + length;
+    while (offset + 4 <= end) {
+        uint32_t entry = get_u32(file, offset);
+        if (entry > end - offset - 4) {
+            break;
+        }
+        const char* key = reinterpret_cast<const char*>(file.data() + offset + 4);
+        size_t key_length = strnlen(key, entry);
+        if (key_length < entry && std::string_view{key, key_length} == "KTXorientation") {
+            const char* value = key + key_length + 1;
+            return std::string{value, strnlen(value, entry - key_length - 1)};
+        }
+        offset = align_up(offset + 4 + entry, 4);
+    }
+    // the spec's default when the key is missing
+    return "rd";
+}
+
+std::optional<Ktx2Texture> ReadKtx2(const std::filesystem::path& path)
+{
+    std::ifstream stream{path, std::ios::binary};
+    if (!stream) {
+        std::cout << "Failed to open KTX2 file " << path << std::endl;
+        return std::nullopt;
+    }
+    std::vector<uint8_t> file{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+    if (file.size() < KTX2_HEADER_SIZE || std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        std::cout << path << " is not a KTX2 file" << std::endl;
+        return std::nullopt;
+    }
+
+    Ktx2Texture texture;
+    texture.format = static_cast<Ktx2Format>(get_u32(file, 12));
+    texture.width = get_u32(file, 20);
+    texture.height = get_u32(file, 24);
+    uint32_t depth = get_u32(file, 28);
+    uint32_t layers = get_u32(file, 32);
+    uint32_t faces = get_u32(file, 36);
+    uint32_t level_count = std::max(1u, get_u32(file, 40));
+    uint32_t supercompression = get_u32(file, 44);
+    if (Ktx2BlockBytes(texture.format) == 0 || depth > 1 || layers > 1 || faces != 1 || supercompression != 0 ||
+        texture.width == 0 || texture.height == 0) {
+        std::cout << path << ": only single 2D images in BC1/BC3/BC7 without supercompression are supported" << std::endl;
+        return std::nullopt;
+    }
+    if (level_count > 32 || file.size() < KTX2_HEADER_SIZE + level_count * KTX2_LEVEL_ENTRY_SIZE) {
+        std::cout << path << " is truncated" << std::endl;
+        return std::nullopt;
+    }
+    uint32_t kvd_offset = get_u32(file, 56);
+    uint32_t kvd_length = get_u32(file, 60);
+    if (kvd_length > 0 && static_cast<size_t>(kvd_offset) + kvd_length <= file.size()) {
+        texture.orientation = find_orientation(file, kvd_offset, kvd_length);
+    }
+
+    for (uint32_t level = 0; level < level_count; ++level) {
+        size_t entry = KTX2_HEADER_SIZE + level * KTX2_LEVEL_ENTRY_SIZE;
+        uint64_t offset = get_u64(file, entry);
+        uint64_t size = get_u64(file, entry + 8);
+        uint32_t width = std::max(1u, texture.width >> level);
+        uint32_t height = std::max(1u, texture.height >> level);
+        if (size != Ktx2LevelSize(texture.format, width, height) || offset > file.size() || size > file.size() - offset) {
+            std::cout << path << ": level " << level << " has the wrong size" << std::endl;
+            return std::nullopt;
+        }
+        texture.levels.push_back(Ktx2Level{texture.data.size(), static_cast<size_t>(size)});
+        texture.data.insert(texture.data.end(), file.begin() + static_cast<std::ptrdiff_t>(offset),
+            file.begin() + static_cast<std::ptrdiff_t>(offset + size));
+    }
+    return texture;
+}
+
+bool WriteKtx2(const std::filesystem::path& path, const Ktx2Texture& texture)
+{
+    std::vector<uint8_t> dfd = build_dfd(texture.format);
+    std::vector<uint8_t> kvd = build_kvd(texture);
+    size_t level_count = texture.levels.size();
+    size_t dfd_offset = KTX2_HEADER_SIZE + level_count * KTX2_LEVEL_ENTRY_SIZE;
+    size_t kvd_offset = dfd_offset + dfd.size();
+
+    std::vector<uint8_t> file(kvd_offset + kvd.size(), 0);
+    std::memcpy(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    put_u32(file, 12, static_cast<uint32_t>(texture.format));
+    // typeSize is 1 for block-compressed formats; layer count 0 means not an array
+    put_u32(file, 16, 1);
+    put_u32(file, 20, texture.width);
+    put_u32(file, 24, texture.height);
+    put_u32(file, 28, 0);
+    put_u32(file, 32, 0);
+    put_u32(file, 36, 1);
+    put_u32(file, 40, static_cast<uint32_t>(level_count));
+    put_u32(file, 44, 0);
+    put_u32(file, 48, static_cast<uint32_t>(dfd_offset));
+    put_u32(file, 52, static_cast<uint32_t>(dfd.size()));
+    put_u32(file, 56, static_cast<uint32_t>(kvd_offset));
+    put_u32(file, 60, static_cast<uint32_t>(kvd.size()));
+    std::copy(dfd.begin(), dfd.end(), file.begin() + static_cast<std::ptrdiff_t>(dfd_offset));
+    std::copy(kvd.begin(), kvd.end(), file.begin() + static_cast<std::ptrdiff_t>(kvd_offset));
+
+    // the mip data goes smallest level first, each level aligned to the block size
+    size_t alignment = Ktx2BlockBytes(texture.format);
+    for (size_t level = level_count; level-- > 0;) {
+        const Ktx2Level& source = texture.levels[level];
+        size_t offset = align_up(file.size(), alignment);
+        file.resize(offset, 0);
+        file.insert(file.end(), texture.data.begin() + static_cast<std::ptrdiff_t>(source.offset),
+            texture.data.begin() + static_cast<std::ptrdiff_t>(source.offset + source.size));
+        size_t entry = KTX2_HEADER_SIZE + level * KTX2_LEVEL_ENTRY_SIZE;
+        put_u64(file, entry, offset);
+        put_u64(file, entry + 8, source.size);
+        put_u64(file, entry + 16, source.size);
+    }
+
+    std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+    stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!stream) {
+        std::cout << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The VkFormat values KTX2 identifies its payload by. Only the block-compressed formats texbake
+// writes are listed; the loader falls back to the source image for anything else.
+enum class Ktx2Format : uint32_t
+{
+    UNDEFINED = 0,
+    BC1_RGB_UNORM = 131,
+    BC1_RGB_SRGB = 132,
+    BC3_UNORM = 137,
+    BC3_SRGB = 138,
+    BC7_UNORM = 145,
+    BC7_SRGB = 146,
+};
+
+// bytes per 4x4 block, 0 for formats this code doesn't know
+uint32_t Ktx2BlockBytes(Ktx2Format format);
+bool Ktx2IsSrgb(Ktx2Format format);
+const char* Ktx2FormatName(Ktx2Format format);
+// payload size of one level with the given dimensions, partial blocks rounded up
+size_t Ktx2LevelSize(Ktx2Format format, uint32_t width, uint32_t height);
+
+struct Ktx2Level
+{
+    size_t offset;
+    size_t size;
+};
+
+// A single-layer 2D texture with its mip chain. levels[0] is the full-size image; all levels
+// live in one buffer so the whole payload can be staged with a single copy.
+struct Ktx2Texture
+{
+    Ktx2Format format = Ktx2Format::UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // KTXorientation: "rd" stores the top row first (image order), "ru" the bottom row first (GL order)
+    std::string orientation = "rd";
+    std::vector<uint8_t> data;
+    std::vector<Ktx2Level> levels;
+};
+
+// reads a KTX2 file without supercompression; prints the reason and returns nothing on failure
+std::optional<Ktx2Texture> ReadKtx2(const std::filesystem::path& path);
+bool WriteKtx2(const std::filesystem::path& path, const Ktx2Texture& texture);
@@ -4,15 +4,44 @@
 #include "glm/trigonometric.hpp"
 #include "shader.h"
 #include "camera.h"
+#include "mesh.h"
+#include "gl_extensions.h"
+#include "indirect_renderer.h"
+#include "dynamic_ring_buffer.h"
+#include "headless_context.h"
+#include "framebuffer.h"
+#include "frame_profiler.h"
+#include "trace.h"
+#include "render_queue.h"
+#include "gl_state_cache.h"
+#include "transform_system.h"
+#include "frustum_culler.h"
+#include "program_cache.h"
+#include "shader_variants.h"
+#include "shader_preprocessor.h"
+#include "texture_loader.h"
+#include "texture_array_packer.h"
+#include "bindless_materials.h"
+#include "file_watcher.h"
+#include "frame_constants.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <stb_image.h>
 
 #include <iostream>
 #include <vector>
 #include <filesystem>
 #include <fstream>
+#include <cstring>
+#include <random>
+#include <string>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -32,6 +61,74 @@ float last_y = HEIGHT / 2.0f;
 
 bool first_mouse = true;
 
+inline static constexpr uint32_t RING_FRAMES = 3;
+
+enum class RenderMode
+{
+    LOOP,
+    INSTANCED,
+    INDIRECT
+};
+
+enum class TextureMode
+{
+    BOUND,
+    ARRAY,
+    BINDLESS
+};
+
+struct Options
+{
+    RenderMode mode = RenderMode::LOOP;
+    TextureMode texture_mode = TextureMode::BOUND;
+    size_t cube_count = 10;
+    bool headless = false;
+    uint32_t frame_count = 1000;
+    std::string profile_path;
+    std::string trace_path;
+    bool shader_cache = true;
+};
+
+// GL resources the frame loop draws with; created once a context is current and released before it goes away
+struct Scene
+{
+    std::unique_ptr<DynamicRingBuffer> ring;
+    int32_t ubo_alignment = 256;
+    uint32_t vao = 0;
+    uint32_t vbo = 0;
+    uint32_t texture1_id = 0;
+    uint32_t texture2_id = 0;
+    std::unique_ptr<TextureLoader> textures;
+    // every texture pairing objects are drawn with; object i uses materials[i % materials.size()]
+    std::vector<Material> materials;
+    // the options' texture mode, until the textures turn out not to fit one array
+    TextureMode texture_mode = TextureMode::BOUND;
+    std::unique_ptr<TextureArrayPacker> texture_arrays;
+    // the array holding every material's images and the uniform buffer with their layers, 0 until packed
+    uint32_t texture_array = 0;
+    uint32_t material_buffer = 0;
+    // resident handles of every material's images in bindless mode, null until the textures are loaded
+    std::unique_ptr<BindlessMaterialTable> bindless_materials;
+    ShaderVariantCache shaders;
+    Shader* shader = nullptr;
+    Shader* indirect_shader = nullptr;
+    // generation of each program whose uniforms were last set up; a mismatch means a fresh program
+    uint32_t shader_generation = 0;
+    uint32_t indirect_shader_generation = 0;
+    std::unique_ptr<IndirectRenderer> indirect_renderer;
+    std::vector<uint32_t> indirect_meshes;
+    std::vector<glm::vec3> cube_positions;
+    TransformSystem transforms;
+    FrustumCuller culler;
+    std::vector<uint32_t> visible;
+    std::vector<glm::mat4> models;
+    RenderQueue queue;
+    uint32_t queue_program = 0;
+    uint32_t queue_mesh = 0;
+    std::vector<uint32_t> queue_materials;
+    std::unique_ptr<FrameProfiler> profiler;
+};
+
 static void framebuffer_size_callback(GLFWwindow* window, int32_t width, int32_t height)
 {
     (void)window;
@@ -43,9 +140,9 @@ static void process_input(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     } else if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        gl_state.PolygonMode(GL_LINE);
     } else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        gl_state.PolygonMode(GL_FILL);
     } else if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
         camera.ProcessKeyboard(CameraMovement::FORWARD, delta_time);
     } else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
@@ -62,7 +159,7 @@ static std::vector<char> read_file(const std::filesystem::path& file_path)
 {
     std::ifstream file{file_path, std::ios::binary | std::ios::ate};
     if (!file) {
-        throw std::runtime_error(file_path.u8string() + ": " + std::strerror(errno));
+        throw std::runtime_error(file_path.string() + ": " + std::strerror(errno));
     }
     auto end = file.tellg();
     file.seekg(0, std::ios::beg);
@@ -73,7 +170,7 @@ static std::vector<char> read_file(const std::filesystem::path& file_path)
     }
     std::vector<char> buffer(size);
     if (!file.read(buffer.data(), buffer.size())) {
-        throw std::runtime_error(file_path.u8string() + ": " + std::strerror(errno));
+        throw std::runtime_error(file_path.string() + ": " + std::strerror(errno));
     }
     return buffer;
 }
@@ -118,227 +215,756 @@ void scroll_calback(GLFWwindow* window, double x_offset, double y_offset)
     camera.ProcessMouseScroll(static_cast<float>(y_offset));
 }
 
-int main()
+static void print_usage(const char* program)
 {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    std::cout << "Usage: " << program << " [--mode loop|instanced|indirect] [--textures bound|array|bindless] [--cubes N] [--headless] [--frames N] [--profile PATH] [--trace PATH] [--no-shader-cache]" << std::endl;
+    std::cout << "  --mode loop       one glDrawArrays and one model upload per cube (default)" << std::endl;
+    std::cout << "  --mode instanced  all cubes in one glDrawArraysInstanced call" << std::endl;
+    std::cout << "  --mode indirect   mixed meshes in one glMultiDrawElementsIndirect call (GL 4.3+)" << std::endl;
+    std::cout << "  --textures bound  one 2D texture per material image, rebound on material changes (default)" << std::endl;
+    std::cout << "  --textures array  all material images packed into one texture array, selected by layer in the shader" << std::endl;
+    std::cout << "  --textures bindless resident texture handles in a storage buffer, indexed by material in the shader" << std::endl;
+    std::cout << "                    (ARB_bindless_texture; the instanced and indirect modes also need NV_gpu_shader5)" << std::endl;
+    std::cout << "  --cubes N         number of objects to draw (default 10)" << std::endl;
+    std::cout << "  --headless        render offscreen through EGL (no window or display needed) and print frame statistics" << std::endl;
+    std::cout << "  --frames N        number of frames to render in headless mode (default 1000)" << std::endl;
+    std::cout << "  --profile PATH    write per-phase frame timings to PATH.csv and PATH.json on exit" << std::endl;
+    std::cout << "  --trace PATH      record CPU/GPU zones and write them as Chrome trace JSON to PATH" << std::endl;
+    std::cout << "  --no-shader-cache always compile shaders instead of loading cached program binaries" << std::endl;
+}
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Learn OpenGL", nullptr, nullptr);
-    if (!window) {
-        std::cout << "Failed to create window" << std::endl;
-        glfwTerminate();
-        return -1;
+// false when value isn't a number that fits an unsigned long
+static bool parse_count(const char* value, unsigned long& count)
+{
+    try {
+        count = std::stoul(value);
+    } catch (const std::invalid_argument&) {
+        return false;
+    } catch (const std::out_of_range&) {
+        return false;
     }
-    glfwMakeContextCurrent(window);
+    return true;
+}
 
-    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--mode" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "loop") {
+                options.mode = RenderMode::LOOP;
+            } else if (value == "instanced") {
+                options.mode = RenderMode::INSTANCED;
+            } else if (value == "indirect") {
+                options.mode = RenderMode::INDIRECT;
+            } else {
+                std::cout << "Unknown render mode: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--textures" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "bound") {
+                options.texture_mode = TextureMode::BOUND;
+            } else if (value == "array") {
+                options.texture_mode = TextureMode::ARRAY;
+            } else if (value == "bindless") {
+                options.texture_mode = TextureMode::BINDLESS;
+            } else {
+                std::cout << "Unknown texture mode: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--cubes" && i + 1 < argc) {
+            unsigned long count = 0;
+            if (!parse_count(argv[++i], count)) {
+                std::cout << "Invalid cube count: " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return false;
+            }
+            options.cube_count = count;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            unsigned long count = 0;
+            if (!parse_count(argv[++i], count) || count > UINT32_MAX) {
+                std::cout << "Invalid frame count: " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return false;
+            }
+            options.frame_count = static_cast<uint32_t>(count);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            options.profile_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.trace_path = argv[++i];
+        } else if (arg == "--no-shader-cache") {
+            options.shader_cache = false;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
     }
+    return true;
+}
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_calback);
+static std::vector<glm::vec3> make_cube_positions(size_t count)
+{
+    std::vector<glm::vec3> positions = {
+        glm::vec3{ 0.0f,  0.0f,  0.0f}, 
+        glm::vec3{ 2.0f,  5.0f, -15.0f}, 
+        glm::vec3{-1.5f, -2.2f, -2.5f},  
+        glm::vec3{-3.8f, -2.0f, -12.3f},  
+        glm::vec3{ 2.4f, -0.4f, -3.5f},  
+        glm::vec3{-1.7f,  3.0f, -7.5f},  
+        glm::vec3{ 1.3f, -2.0f, -2.5f},  
+        glm::vec3{ 1.5f,  2.0f, -2.5f}, 
+        glm::vec3{ 1.5f,  0.2f, -1.5f}, 
+        glm::vec3{-1.3f,  1.0f, -1.5f}  
+    };
+    positions.resize(std::min(count, positions.size()));
+    // the rest are scattered with a fixed seed so every run draws the same scene
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> xy{-40.0f, 40.0f};
+    std::uniform_real_distribution<float> z{-95.0f, -5.0f};
+    positions.reserve(count);
+    while (positions.size() < count) {
+        positions.emplace_back(xy(rng), xy(rng), z(rng));
+    }
+    return positions;
+}
 
-    // float vertices[] = {
-    //     // positions                        // colors                   // texture coords
-    //     0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // top right
-    //     0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,   // bottom right
-    //     -0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // bottom left
-    //     -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // top left     // top
-    // };
-
-
-float vertices[] = {
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-
-    -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-
-    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-
-    -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f
-};
+static glm::quat cube_rotation(size_t index, float time)
+{
+    static const glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+    float angle = (index == 0 ? 20.0f : 20.0f * index);
+    return glm::angleAxis(time * glm::radians(angle), axis);
+}
 
+// both images load on the loader's workers, from their baked KTX2 containers where possible; until
+// they are resident the names hold a placeholder
+static void load_textures(Scene& scene)
+{
+    TRACE_SCOPE("load_textures");
+    scene.textures = std::make_unique<TextureLoader>();
+#ifdef BAKED_TEXTURE_DIR
+    scene.textures->SetBakedDirectory(BAKED_TEXTURE_DIR);
+#endif
+    scene.texture1_id = scene.textures->Load("assets/textures/container.jpg");
+    TextureParams face_params{};
+    face_params.min_filter = GL_LINEAR;
+    scene.texture2_id = scene.textures->Load("assets/textures/awesomeface.png", face_params);
+}
 
-    uint32_t indices[] = {  // note that we start from 0!
-        0, 1, 3,   // first triangle
-        1, 2, 3    // second triangle
-    }; 
+// submits every permutation the render and texture mode draw with in one go; the driver
+// compiles them while the texture workers decode
+static void use_shaders(Scene& scene, RenderMode mode, TextureMode texture_mode)
+{
+    ShaderDefines defines{{"TEXTURE_MIX", ""}};
+    if (texture_mode == TextureMode::ARRAY) {
+        defines.push_back({"TEXTURE_ARRAY", ""});
+    } else if (texture_mode == TextureMode::BINDLESS) {
+        defines.push_back({"TEXTURE_BINDLESS", ""});
+        if (mode != RenderMode::LOOP) {
+            defines.push_back({"TEXTURE_BINDLESS_PER_INSTANCE", ""});
+        }
+    }
+    // bindless sampling needs GLSL 4.00, which the shared fragment shader can't require
+    const char* fragment = texture_mode == TextureMode::BINDLESS ? "assets/shaders/bindless.frag" : "assets/shaders/triangle.frag";
+    ShaderDefines triangle_defines = defines;
+    if (mode == RenderMode::INSTANCED) {
+        triangle_defines.push_back({"INSTANCED", ""});
+    }
+    std::vector<ShaderVariant> variants{{"assets/shaders/triangle.vert", fragment, triangle_defines}};
+    if (mode == RenderMode::INDIRECT) {
+        variants.push_back({"assets/shaders/indirect.vert", fragment, defines});
+    }
+    scene.shaders.Precompile(variants);
+    scene.shader = &scene.shaders.Get(variants[0]);
+    scene.indirect_shader = mode == RenderMode::INDIRECT ? &scene.shaders.Get(variants[1]) : nullptr;
+    scene.shader_generation = 0;
+    scene.indirect_shader_generation = 0;
+}
 
-    uint32_t vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    uint32_t vbo = 0;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+static bool create_scene(Scene& scene, const Options& options)
+{
+    TRACE_SCOPE("create_scene");
+    // all transient data (frame constants, instance matrices, indirect commands) is streamed through here
+    size_t ring_frame_size = options.cube_count * (sizeof(glm::mat4) + sizeof(uint32_t)) + 64 * 1024;
+    scene.ring = std::make_unique<DynamicRingBuffer>(ring_frame_size, RING_FRAMES);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &scene.ubo_alignment);
+
+    glGenVertexArrays(1, &scene.vao);
+    gl_state.BindVertexArray(scene.vao);
+    glGenBuffers(1, &scene.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vbo);
+    MeshData cube = MakeCubeMesh();
+    glBufferData(GL_ARRAY_BUFFER, cube.vertices.size() * sizeof(float), cube.vertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(0));
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
-    
 
-    // uint32_t ebo = 0;
-    // glGenBuffers(1, &ebo);
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    // per-instance model matrices, one vec4 column per attribute slot (3..6); they are sourced from
+    // the ring buffer and re-pointed at the current frame's allocation before each instanced draw
+    glBindBuffer(GL_ARRAY_BUFFER, scene.ring->GetBufferId());
+    for (uint32_t column = 0; column < 4; ++column) {
+        uint32_t location = 3 + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void*>(column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    // and with texture arrays or bindless textures a material index per instance (slot 7), sourced the same way
+    scene.texture_mode = options.texture_mode;
+    if (scene.texture_mode != TextureMode::BOUND) {
+        glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(uint32_t), reinterpret_cast<void*>(0));
+        glEnableVertexAttribArray(7);
+        glVertexAttribDivisor(7, 1);
+    }
 
-    glBindVertexArray(0);
+    gl_state.BindVertexArray(0);
 
+#ifdef SPIRV_SHADER_DIR
+    scene.shaders.SetSpirvDirectory(SPIRV_SHADER_DIR);
+#endif
+    use_shaders(scene, options.mode, scene.texture_mode);
 
-    uint32_t texture1_id = 0;
-    glGenTextures(1, &texture1_id);
-    glBindTexture(GL_TEXTURE_2D, texture1_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    int32_t img_width = 0;
-    int32_t img_height = 0;
-    int32_t nr_channels = 0;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* img_data = stbi_load("assets/textures/container.jpg", &img_width, &img_height, &nr_channels, 0);
-    if (!img_data) {
-        std::cout << "Failed to load image" << std::endl;
+    load_textures(scene);
+    // object i is drawn with material i % 2; the instanced and indirect paths can only do that with
+    // texture arrays or bindless textures and otherwise draw everything with the first one
+    scene.materials.push_back(Material{{scene.texture1_id, scene.texture2_id}});
+    scene.materials.push_back(Material{{scene.texture2_id, scene.texture1_id}});
+
+    gl_state.SetEnabled(GL_BLEND, true);// you enable blending function
+    gl_state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl_state.SetEnabled(GL_DEPTH_TEST, true);
+
+    // glm::mat4 trans{1.0f};
+    // trans = glm::rotate(trans, glm::radians(90.0f), glm::vec3{0.0f, 0.0f, 1.0f});
+    // trans = glm::scale(trans, glm::vec3{0.5f, 0.5f, 0.5f});
+
+    // shader.setMatrix4("transform", trans);
+    scene.cube_positions = make_cube_positions(options.cube_count);
+    scene.transforms.Reserve(scene.cube_positions.size());
+    for (const glm::vec3& position : scene.cube_positions) {
+        scene.transforms.Add(position, glm::quat{1.0f, 0.0f, 0.0f, 0.0f}, glm::vec3{1.0f});
+    }
+    // bounding sphere of the unit cube, independent of its rotation
+    scene.culler.Resize(scene.cube_positions.size(), std::sqrt(0.75f));
+
+    // the indirect path cycles through several meshes to show off heterogeneous batches
+    if (options.mode == RenderMode::INDIRECT) {
+        scene.indirect_renderer = std::make_unique<IndirectRenderer>();
+        scene.indirect_meshes.push_back(scene.indirect_renderer->AddMesh(MakeCubeMesh()));
+        scene.indirect_meshes.push_back(scene.indirect_renderer->AddMesh(MakePyramidMesh()));
+        scene.indirect_meshes.push_back(scene.indirect_renderer->AddMesh(MakeOctahedronMesh()));
+    }
+    // the loop path sorts its draws by material so the queue can batch the texture changes
+    if (options.mode == RenderMode::LOOP) {
+        scene.queue_program = scene.queue.RegisterProgram(scene.shader);
+        scene.queue_mesh = scene.queue.RegisterMesh(MeshRange{scene.vao, 0, 36});
+        for (const Material& material : scene.materials) {
+            scene.queue_materials.push_back(scene.queue.RegisterMaterial(material));
+        }
+    }
+    scene.profiler = std::make_unique<FrameProfiler>();
+    return true;
+}
+
+// polls the async builds (initial or hot reload) and sets the per-program uniforms whenever a new
+// program was swapped in; true when every program can draw
+static bool prepare_shaders(Scene& scene)
+{
+    if (!scene.shaders.IsReady()) {
+        return false;
+    }
+
+    if (scene.shader->GetGeneration() != scene.shader_generation) {
+        scene.shader->setInteger("texture1", 0);
+        scene.shader->setInteger("texture2", 1);
+        scene.shader->setInteger("textures", 0);
+        scene.shader->BindUniformBlock(MATERIAL_LAYERS_BLOCK, MATERIAL_LAYERS_BINDING);
+        scene.shader_generation = scene.shader->GetGeneration();
+    }
+    if (scene.indirect_shader && scene.indirect_shader->GetGeneration() != scene.indirect_shader_generation) {
+        scene.indirect_shader->setInteger("texture1", 0);
+        scene.indirect_shader->setInteger("texture2", 1);
+        scene.indirect_shader->setInteger("textures", 0);
+        scene.indirect_shader->BindUniformBlock(MATERIAL_LAYERS_BLOCK, MATERIAL_LAYERS_BINDING);
+        scene.indirect_shader_generation = scene.indirect_shader->GetGeneration();
+    }
+    return true;
+}
+
+// goes back to one bound texture per image, e.g. when the images can't share an array
+static void use_bound_textures(Scene& scene, RenderMode mode)
+{
+    scene.texture_mode = TextureMode::BOUND;
+    scene.texture_arrays.reset();
+    use_shaders(scene, mode, TextureMode::BOUND);
+    gl_state.BindVertexArray(scene.vao);
+    glDisableVertexAttribArray(7);
+    gl_state.BindVertexArray(0);
+    if (mode == RenderMode::LOOP) {
+        scene.queue_program = scene.queue.RegisterProgram(scene.shader);
+    }
+}
+
+// makes the material images resident once they are loaded and uploads their handles in material
+// order, so the material index the draws carry selects them directly
+static void prepare_bindless_textures(Scene& scene)
+{
+    scene.bindless_materials = std::make_unique<BindlessMaterialTable>();
+    for (const Material& material : scene.materials) {
+        scene.bindless_materials->Add(material);
+    }
+    scene.bindless_materials->Upload();
+    // the shaders never sample a texture unit, so the queue only ever changes the material index
+    for (uint32_t material : scene.queue_materials) {
+        scene.queue.SetMaterial(material, Material{{0, 0}});
+    }
+}
+
+// in texture array mode, packs the material images into one array once they are resident and
+// uploads the layers of every material, in bindless mode uploads their handles; true when the
+// textures are ready to draw with
+static bool prepare_textures(Scene& scene, RenderMode mode)
+{
+    if (scene.texture_mode == TextureMode::BOUND || scene.texture_array || scene.bindless_materials) {
+        return true;
+    }
+    if (!scene.textures->IsIdle()) {
+        return false;
+    }
+    if (scene.texture_mode == TextureMode::BINDLESS) {
+        prepare_bindless_textures(scene);
+        return true;
+    }
+    std::vector<uint32_t> images;
+    for (const Material& material : scene.materials) {
+        images.insert(images.end(), material.textures.begin(), material.textures.end());
+    }
+    scene.texture_arrays = std::make_unique<TextureArrayPacker>();
+    std::vector<TextureLayer> layers = scene.texture_arrays->Pack(images);
+    // the batched draws sample a single array, so every image has to have ended up in the same one
+    if (scene.texture_arrays->GetArrays().size() != 1 || scene.materials.size() > MAX_LAYERED_MATERIALS) {
+        std::cout << "The material textures differ in size or level count, drawing with bound textures instead of an array" << std::endl;
+        use_bound_textures(scene, mode);
+        return false;
+    }
+    scene.texture_array = scene.texture_arrays->GetArrays()[0];
+
+    // sized for the whole block, GL doesn't allow binding less than a block declares
+    std::vector<std::array<int32_t, 4>> material_layers(MAX_LAYERED_MATERIALS);
+    for (size_t material = 0; material < scene.materials.size(); ++material) {
+        for (uint32_t unit = 0; unit < MATERIAL_TEXTURE_UNITS; ++unit) {
+            material_layers[material][unit] = static_cast<int32_t>(layers[material * MATERIAL_TEXTURE_UNITS + unit].layer);
+        }
+    }
+    glGenBuffers(1, &scene.material_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, scene.material_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(material_layers.size() * sizeof(material_layers[0])), material_layers.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_LAYERS_BINDING, scene.material_buffer);
+
+    // every material now binds the same array, so the queue only ever changes the material index
+    for (uint32_t material : scene.queue_materials) {
+        scene.queue.SetMaterial(material, Material{{scene.texture_array, 0}, GL_TEXTURE_2D_ARRAY});
+    }
+    return true;
+}
+
+static void watch_shaders(Scene& scene, FileWatcher& watcher)
+{
+    for (Shader* shader : scene.shaders.GetShaders()) {
+        for (const std::filesystem::path& path : shader->GetSourcePaths()) {
+            watcher.Watch(path);
+        }
+    }
+}
+
+// kicks off background rebuilds for programs whose sources changed; prepare_shaders swaps them in
+static void reload_changed_shaders(Scene& scene, FileWatcher& watcher)
+{
+    std::vector<std::filesystem::path> changed = watcher.Poll();
+    if (changed.empty()) {
+        return;
+    }
+    for (Shader* shader : scene.shaders.GetShaders()) {
+        for (const std::filesystem::path& source : shader->GetSourcePaths()) {
+            std::error_code error;
+            auto matches = [&source, &error](const std::filesystem::path& path) {
+                return std::filesystem::equivalent(source, path, error);
+            };
+            if (std::any_of(changed.begin(), changed.end(), matches)) {
+                std::cout << "Reloading " << source << std::endl;
+                shader->Reload();
+                break;
+            }
+        }
+    }
+    // a reload may have pulled in new includes
+    watch_shaders(scene, watcher);
+}
+
+static void render_scene(Scene& scene, const Options& options, float time)
+{
+    DynamicRingBuffer& ring = *scene.ring;
+    FrameProfiler& profiler = *scene.profiler;
+    const std::vector<glm::vec3>& cube_positions = scene.cube_positions;
+    Tracer::CollectGpuZones(false);
+    ring.BeginFrame();
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), static_cast<float>(WIDTH) / static_cast<float>(HEIGHT), 0.1f, 100.0f);
+    const std::vector<uint32_t>& visible = scene.visible;
+    {
+        ScopedPhase phase{profiler, FramePhase::CULL};
+        TRACE_SCOPE("cull");
+        scene.culler.Cull(camera.GetFrustum(projection), scene.transforms, scene.visible);
+    }
+
+    RingAllocation frame_constants{};
+    RingAllocation instances{};
+    RingAllocation instance_materials{};
+    // texture arrays and bindless textures both pick the images by a material index per object
+    bool layered = scene.texture_mode != TextureMode::BOUND;
+    {
+        ScopedPhase phase{profiler, FramePhase::MATRIX_BUILD};
+        TRACE_SCOPE("matrix_build");
+        frame_constants = ring.Allocate(sizeof(FrameConstants), static_cast<size_t>(scene.ubo_alignment));
+        auto* constants = static_cast<FrameConstants*>(frame_constants.data);
+        constants->view = camera.GetViewMatrix();
+        constants->projection = projection;
+        constants->view_projection = projection * constants->view;
+        constants->camera_position = camera.GetPosition();
+        constants->time = time;
+
+        // only survivors of culling are animated and composed; slot k of the output belongs to cube visible[k]
+        for (uint32_t index : visible) {
+            scene.transforms.SetRotation(index, cube_rotation(index, time));
+        }
+        // instanced matrices are composed straight into the mapped ring, the other paths need a copy per object anyway
+        if (options.mode == RenderMode::INSTANCED) {
+            if (!visible.empty()) {
+                instances = ring.Allocate(visible.size() * sizeof(glm::mat4), sizeof(glm::mat4));
+                scene.transforms.ComposeMatrices(visible.data(), visible.size(), static_cast<glm::mat4*>(instances.data));
+            }
+            if (layered && !visible.empty()) {
+                instance_materials = ring.Allocate(visible.size() * sizeof(uint32_t), sizeof(uint32_t));
+                auto* materials = static_cast<uint32_t*>(instance_materials.data);
+                for (size_t k = 0; k < visible.size(); ++k) {
+                    materials[k] = static_cast<uint32_t>(visible[k] % scene.materials.size());
+                }
+            }
+        } else {
+            scene.models.resize(visible.size());
+            scene.transforms.ComposeMatrices(visible.data(), visible.size(), scene.models.data());
+        }
+
+        if (options.mode == RenderMode::INDIRECT) {
+            for (size_t k = 0; k < visible.size(); ++k) {
+                uint32_t material = layered ? static_cast<uint32_t>(visible[k] % scene.materials.size()) : 0;
+                scene.indirect_renderer->Submit(scene.indirect_meshes[visible[k] % scene.indirect_meshes.size()], scene.models[k], material);
+            }
+            scene.indirect_renderer->Prepare(ring);
+        } else if (options.mode == RenderMode::LOOP) {
+            scene.queue.Clear();
+            for (size_t k = 0; k < visible.size(); ++k) {
+                float depth = glm::length(cube_positions[visible[k]] - camera.GetPosition()) / 100.0f;
+                uint32_t material = scene.queue_materials[visible[k] % scene.queue_materials.size()];
+                scene.queue.Push(RenderKey::Make(0, false, depth, scene.queue_program, material, scene.queue_mesh), scene.models[k]);
+            }
+            scene.queue.Sort();
+        }
+    }
+    {
+        ScopedPhase phase{profiler, FramePhase::UNIFORM_UPLOAD};
+        TRACE_SCOPE("uniform_upload");
+        ring.Commit();
+        scene.textures->Update();
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, ring.GetBufferId(), static_cast<GLintptr>(frame_constants.offset),
+            static_cast<GLsizeiptr>(frame_constants.size));
+    }
+
+    // in the loop path the per-cube glUniform upload is interleaved with its draw, so it counts as submission
+    ScopedPhase phase{profiler, FramePhase::DRAW_SUBMIT};
+    TRACE_SCOPE("draw_submit");
+    TRACE_GPU_SCOPE("draw");
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // draws are skipped until the async shader builds finish and, with texture arrays or bindless
+    // textures, until the textures are packed or resident; the frame still clears and presents
+    if (!prepare_shaders(scene) || !prepare_textures(scene, options.mode)) {
+        ring.EndFrame();
+        return;
+    }
+
+    // the render queue binds its own program, textures and VAO
+    if (options.mode != RenderMode::LOOP) {
+        if (scene.texture_mode == TextureMode::ARRAY) {
+            gl_state.BindTexture(0, GL_TEXTURE_2D_ARRAY, scene.texture_array);
+        } else if (scene.texture_mode == TextureMode::BOUND) {
+            gl_state.BindTexture(0, GL_TEXTURE_2D, scene.texture1_id);
+            gl_state.BindTexture(1, GL_TEXTURE_2D, scene.texture2_id);
+        }
+
+        Shader& active_shader = scene.indirect_shader ? *scene.indirect_shader : *scene.shader;
+        active_shader.Use();
+        active_shader.Flush();
+    }
+
+    if (options.mode == RenderMode::INDIRECT) {
+        scene.indirect_renderer->Draw();
+    } else if (options.mode == RenderMode::INSTANCED) {
+        gl_state.BindVertexArray(scene.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, ring.GetBufferId());
+        for (uint32_t column = 0; column < 4; ++column) {
+            size_t offset = instances.offset + column * sizeof(glm::vec4);
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void*>(offset));
+        }
+        if (layered) {
+            glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(uint32_t), reinterpret_cast<void*>(instance_materials.offset));
+        }
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<int32_t>(visible.size()));
+    } else {
+        scene.queue.Submit();
+    }
+    ring.EndFrame();
+}
+
+static void report_profile(const Scene& scene, const Options& options)
+{
+    scene.profiler->PrintReport();
+    if (!options.profile_path.empty()) {
+        scene.profiler->WriteCsv(options.profile_path + ".csv");
+        scene.profiler->WriteJson(options.profile_path + ".json");
+    }
+}
+
+static void destroy_scene(Scene& scene)
+{
+    Tracer::CollectGpuZones(true);
+    scene.ring->PrintStats();
+    const RenderQueue::Stats& queue_stats = scene.queue.GetStats();
+    if (queue_stats.draws > 0) {
+        std::cout << "render queue: " << queue_stats.draws << " draws, " << queue_stats.program_changes << " program, "
+                  << queue_stats.material_changes << " material, " << queue_stats.mesh_changes << " mesh changes per frame" << std::endl;
+    }
+    gl_state.PrintStats();
+    program_cache.PrintStats();
+    scene.shaders.PrintStats();
+    shader_preprocessor.PrintStats();
+    scene.textures->PrintStats();
+    if (scene.texture_arrays) {
+        scene.texture_arrays->PrintStats();
+    }
+    if (scene.bindless_materials) {
+        scene.bindless_materials->PrintStats();
+        // handles have to be non-resident before their textures go away
+        scene.bindless_materials.reset();
+    }
+    gl_state.OnVertexArrayDeleted(scene.vao);
+    glDeleteVertexArrays(1, &scene.vao);
+    glDeleteBuffers(1, &scene.vbo);
+    gl_state.OnTextureDeleted(scene.texture1_id);
+    gl_state.OnTextureDeleted(scene.texture2_id);
+    glDeleteTextures(1, &scene.texture1_id);
+    glDeleteTextures(1, &scene.texture2_id);
+    glDeleteBuffers(1, &scene.material_buffer);
+    scene = Scene{};
+}
+
+static bool load_gl(GLADloadproc load, Options& options)
+{
+    if (!gladLoadGLLoader(load)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    LoadGLExtensions(load);
+    gl_state.Invalidate();
+    program_cache.SetEnabled(options.shader_cache);
+    program_cache.Initialize("shader_cache");
+    Tracer::CalibrateGpuClock();
+    if (options.mode == RenderMode::INDIRECT && !IndirectRenderer::IsSupported()) {
+        std::cout << "Multi draw indirect needs GL 4.3 and ARB_shader_draw_parameters, falling back to the draw loop" << std::endl;
+        options.mode = RenderMode::LOOP;
+    }
+    if (options.texture_mode == TextureMode::BINDLESS && !BindlessMaterialTable::IsSupported()) {
+        std::cout << "Bindless textures need ARB_bindless_texture, GL 4.0 and SSBOs, falling back to bound textures" << std::endl;
+        options.texture_mode = TextureMode::BOUND;
+    }
+    // the batched paths pick the material per instance
+    if (options.texture_mode == TextureMode::BINDLESS && options.mode != RenderMode::LOOP && !BindlessMaterialTable::IsSupported(true)) {
+        std::cout << "Bindless textures that differ within a draw need NV_gpu_shader5, falling back to bound textures" << std::endl;
+        options.texture_mode = TextureMode::BOUND;
+    }
+    return true;
+}
+
+static int run_windowed(Options& options)
+{
+    TRACE_SCOPE("run_windowed");
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Learn OpenGL", nullptr, nullptr);
+    if (!window) {
+        std::cout << "Failed to create window" << std::endl;
+        glfwTerminate();
         return -1;
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, img_width, img_height, 0, GL_RGB, GL_UNSIGNED_BYTE, img_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(img_data);
+    glfwMakeContextCurrent(window);
 
-    uint32_t texture2_id = 0;
-    glGenTextures(1, &texture2_id);
-    glBindTexture(GL_TEXTURE_2D, texture2_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    img_data = stbi_load("assets/textures/awesomeface.png", &img_width, &img_height, &nr_channels, 0);
-    if (!img_data) {
-        std::cout << "Failed to load image" << std::endl;
+    if (!load_gl(reinterpret_cast<GLADloadproc>(glfwGetProcAddress), options)) {
+        glfwTerminate();
         return -1;
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img_width, img_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(img_data);
 
-    glEnable(GL_BLEND);// you enable blending function
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_calback);
 
-    // glm::mat4 trans{1.0f};
-    // trans = glm::rotate(trans, glm::radians(90.0f), glm::vec3{0.0f, 0.0f, 1.0f});
-    // trans = glm::scale(trans, glm::vec3{0.5f, 0.5f, 0.5f});
+    Scene scene{};
+    if (!create_scene(scene, options)) {
+        glfwTerminate();
+        return -1;
+    }
+    FileWatcher shader_watcher{};
+    watch_shaders(scene, shader_watcher);
 
-    Shader shader("assets/shaders/triangle.vert", "assets/shaders/triangle.frag");
-    shader.Use();
-    shader.setInteger("texture1", 0);
-    shader.setInteger("texture2", 1);
-    // shader.setMatrix4("transform", trans);
-    std::vector<glm::vec3> cube_positions = {
-        glm::vec3{ 0.0f,  0.0f,  0.0f}, 
-        glm::vec3{ 2.0f,  5.0f, -15.0f}, 
-        glm::vec3{-1.5f, -2.2f, -2.5f},  
-        glm::vec3{-3.8f, -2.0f, -12.3f},  
-        glm::vec3{ 2.4f, -0.4f, -3.5f},  
-        glm::vec3{-1.7f,  3.0f, -7.5f},  
-        glm::vec3{ 1.3f, -2.0f, -2.5f},  
-        glm::vec3{ 1.5f,  2.0f, -2.5f}, 
-        glm::vec3{ 1.5f,  0.2f, -1.5f}, 
-        glm::vec3{-1.3f,  1.0f, -1.5f}  
-    };
+    float stats_start = static_cast<float>(glfwGetTime());
+    uint32_t stats_frames = 0;
     while (!glfwWindowShouldClose(window)) {
         float current_frame = static_cast<float>(glfwGetTime());
         delta_time = current_frame - last_frame;
         last_frame = current_frame;
 
-        process_input(window);
-
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1_id);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2_id);
-
-        shader.Use();
-        // glm::vec3 camera_pos{0.0f, 0.0f, 3.0f};
-        // glm::vec3 camera_target{0.0f, 0.0f, 0.0f};
-        // glm::vec3 camera_direction = glm::normalize(camera_pos - camera_target);
-        // glm::vec3 up{0.0f, 1.0f, 0.0f};
-        // glm::vec3 camera_right = glm::normalize(glm::cross(up, camera_direction));
-        // glm::vec3 camera_up = glm::cross(camera_direction, camera_right);
-
-        // glm::mat4 view = glm::mat4{1.0f};
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), static_cast<float>(WIDTH) / static_cast<float>(HEIGHT), 0.1f, 100.0f);
-        shader.setMatrix4("projection", projection);
-
-        glm::mat4 view = camera.GetViewMatrix();
-        shader.setMatrix4("view", view);
-        
-        
-        glBindVertexArray(vao);
-        // glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-        for (int i = 0; i < cube_positions.size(); ++i) {
-            glm::mat4 model = glm::mat4{1.0f};
-            model = glm::translate(model, cube_positions[i]);
-            float angle = (i == 0 ? 20.0f : 20.0f * i);
-            model = glm::rotate(model, static_cast<float>(glfwGetTime()) * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            shader.setMatrix4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        {
+            TRACE_SCOPE("frame");
+            scene.profiler->BeginFrame();
+            {
+                ScopedPhase phase{*scene.profiler, FramePhase::INPUT};
+                TRACE_SCOPE("input");
+                process_input(window);
+                reload_changed_shaders(scene, shader_watcher);
+            }
+            render_scene(scene, options, current_frame);
+            {
+                ScopedPhase phase{*scene.profiler, FramePhase::SWAP};
+                TRACE_SCOPE("swap");
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            scene.profiler->EndFrame();
         }
-        glBindVertexArray(0);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        ++stats_frames;
+        if (current_frame - stats_start >= 1.0f) {
+            float frame_ms = 1000.0f * (current_frame - stats_start) / static_cast<float>(stats_frames);
+            const FrustumCuller::Stats& culled = scene.culler.GetLastFrame();
+            std::cout << scene.cube_positions.size() << " cubes (" << culled.visible << "/" << culled.total << " visible): " << frame_ms
+                      << " ms/frame (" << stats_frames << " fps)" << std::endl;
+            stats_start = current_frame;
+            stats_frames = 0;
+        }
     }
 
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-
+    report_profile(scene, options);
+    destroy_scene(scene);
     glfwTerminate();
     return 0;
+}
+
+static int run_headless(Options& options)
+{
+    TRACE_SCOPE("run_headless");
+    HeadlessContext context{};
+    if (!context.Create(3, 3)) {
+        return -1;
+    }
+    if (!load_gl(HeadlessContext::GetProcAddress, options)) {
+        return -1;
+    }
+
+    Framebuffer target{WIDTH, HEIGHT};
+    if (!target.IsComplete()) {
+        std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+        return -1;
+    }
+    target.Bind();
+    glViewport(0, 0, WIDTH, HEIGHT);
+
+    Scene scene{};
+    if (!create_scene(scene, options)) {
+        return -1;
+    }
+    // a benchmark run must not measure frames that skipped their draws or sampled placeholders
+    auto build_start = std::chrono::steady_clock::now();
+    while (!prepare_shaders(scene) || !scene.textures->IsIdle() || !prepare_textures(scene, options.mode)) {
+        scene.textures->Update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout << "Shaders and textures ready " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count()
+        << " ms after scene setup" << std::endl;
+
+    // the first frames pay for shader JIT and first-touch allocations, keep them out of the statistics
+    constexpr uint32_t warmup_frames = 10;
+    using clock = std::chrono::steady_clock;
+    clock::time_point run_start{};
+    for (uint32_t frame = 0; frame < warmup_frames + options.frame_count; ++frame) {
+        if (frame == warmup_frames) {
+            glFinish();
+            scene.profiler = std::make_unique<FrameProfiler>();
+            gl_state.ResetCounts();
+            Shader::ResetUniformStats();
+            run_start = clock::now();
+        }
+        TRACE_SCOPE("frame");
+        scene.profiler->BeginFrame();
+        // fixed time step so every run animates the same frames
+        render_scene(scene, options, static_cast<float>(frame) / 60.0f);
+        {
+            ScopedPhase phase{*scene.profiler, FramePhase::SWAP};
+            TRACE_SCOPE("swap");
+            glFlush();
+        }
+        scene.profiler->EndFrame();
+    }
+    glFinish();
+    double total_s = std::chrono::duration<double>(clock::now() - run_start).count();
+
+    std::cout << "Headless: " << options.frame_count << " frames, " << scene.cube_positions.size() << " cubes, " << WIDTH << "x" << HEIGHT << std::endl;
+    std::cout << "  throughput: " << static_cast<double>(options.frame_count) / total_s << " fps ("
+        << static_cast<double>(options.frame_count * scene.cube_positions.size()) / total_s << " objects/s)" << std::endl;
+    const FrustumCuller::Stats& culled = scene.culler.GetLastFrame();
+    std::cout << "  culling: " << culled.visible << "/" << culled.total << " visible in the last frame, "
+        << 100.0 * scene.culler.GetAverageVisibleRatio() << "% on average" << std::endl;
+    const Shader::UniformStats& uniforms = Shader::GetUniformStats();
+    std::cout << "  uniforms: " << static_cast<double>(uniforms.sets) / options.frame_count << " sets, "
+        << static_cast<double>(uniforms.uploads) / options.frame_count << " uploads, "
+        << static_cast<double>(uniforms.sets - uniforms.uploads) / options.frame_count << " avoided per frame" << std::endl;
+    report_profile(scene, options);
+
+    destroy_scene(scene);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options options{};
+    if (!parse_options(argc, argv, options)) {
+        return -1;
+    }
+    if (!options.trace_path.empty()) {
+        Tracer::Enable();
+    }
+    int result = options.headless ? run_headless(options) : run_windowed(options);
+    if (!options.trace_path.empty()) {
+        Tracer::WriteChromeTrace(options.trace_path);
+    }
+    return result;
 }
\ No newline at end of file
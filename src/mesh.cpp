@@ -0,0 +1,105 @@
+#include "mesh.h"
+
+MeshData MakeCubeMesh()
+{
+    MeshData mesh{};
+    mesh.vertices = {
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+         0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+         0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+         0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f
+    };
+    for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+        mesh.indices.push_back(i);
+    }
+    return mesh;
+}
+
+static void add_triangle(MeshData& mesh, const float (&corners)[3][3], const float (&uvs)[3][2])
+{
+    for (uint32_t i = 0; i < 3; ++i) {
+        mesh.indices.push_back(mesh.VertexCount());
+        mesh.vertices.insert(mesh.vertices.end(), {corners[i][0], corners[i][1], corners[i][2], 1.0f, 0.0f, 0.0f, uvs[i][0], uvs[i][1]});
+    }
+}
+
+MeshData MakePyramidMesh()
+{
+    MeshData mesh{};
+    const float apex[3] = {0.0f, 0.5f, 0.0f};
+    const float base[4][3] = {
+        {-0.5f, -0.5f,  0.5f},
+        { 0.5f, -0.5f,  0.5f},
+        { 0.5f, -0.5f, -0.5f},
+        {-0.5f, -0.5f, -0.5f}
+    };
+    for (uint32_t i = 0; i < 4; ++i) {
+        const float* a = base[i];
+        const float* b = base[(i + 1) % 4];
+        add_triangle(mesh, {{a[0], a[1], a[2]}, {b[0], b[1], b[2]}, {apex[0], apex[1], apex[2]}},
+            {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.5f, 1.0f}});
+    }
+    add_triangle(mesh, {{base[0][0], base[0][1], base[0][2]}, {base[3][0], base[3][1], base[3][2]}, {base[2][0], base[2][1], base[2][2]}},
+        {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}});
+    add_triangle(mesh, {{base[2][0], base[2][1], base[2][2]}, {base[1][0], base[1][1], base[1][2]}, {base[0][0], base[0][1], base[0][2]}},
+        {{1.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 0.0f}});
+    return mesh;
+}
+
+MeshData MakeOctahedronMesh()
+{
+    MeshData mesh{};
+    const float r = 0.6f;
+    const float ring[4][3] = {
+        {   r, 0.0f, 0.0f},
+        {0.0f, 0.0f,    r},
+        {  -r, 0.0f, 0.0f},
+        {0.0f, 0.0f,   -r}
+    };
+    for (uint32_t i = 0; i < 4; ++i) {
+        const float* a = ring[i];
+        const float* b = ring[(i + 1) % 4];
+        add_triangle(mesh, {{a[0], a[1], a[2]}, {b[0], b[1], b[2]}, {0.0f, r, 0.0f}},
+            {{0.0f, 0.5f}, {1.0f, 0.5f}, {0.5f, 1.0f}});
+        add_triangle(mesh, {{b[0], b[1], b[2]}, {a[0], a[1], a[2]}, {0.0f, -r, 0.0f}},
+            {{1.0f, 0.5f}, {0.0f, 0.5f}, {0.5f, 0.0f}});
+    }
+    return mesh;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// interleaved layout shared by every mesh: position (3), color (3), texture coords (2)
+inline constexpr uint32_t VERTEX_FLOATS = 8;
+
+struct MeshData
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    uint32_t VertexCount() const { return static_cast<uint32_t>(vertices.size() / VERTEX_FLOATS); }
+};
+
+MeshData MakeCubeMesh();
+MeshData MakePyramidMesh();
+MeshData MakeOctahedronMesh();
@@ -0,0 +1,551 @@
+#include "mip_generator.h"
+#include "aligned_allocator.h"
+#include "cpu_features.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float, 32>>;
+
+static constexpr int32_t KAISER_TAPS = 8;
+// an output texel covers source texels 2x and 2x + 1; tap k reads source texel 2x + k - 3
+static constexpr int32_t KAISER_FIRST_TAP = -3;
+static constexpr uint32_t FROM_LINEAR_SIZE = 1 << 14;
+
+using KaiserWeights = std::array<float, KAISER_TAPS>;
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int32_t k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// sinc at the output rate, windowed over a radius of two output texels
+static const KaiserWeights& kaiser_weights()
+{
+    static const KaiserWeights weights = []() {
+        constexpr double alpha = 4.0;
+        constexpr double radius = 2.0;
+        const double pi = std::acos(-1.0);
+        KaiserWeights result{};
+        double sum = 0.0;
+        std::array<double, KAISER_TAPS> raw{};
+        for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+            // distance from the output texel's center, in output texels
+            double t = (k + KAISER_FIRST_TAP + 0.5 - 1.0) / 2.0;
+            double sinc = std::sin(pi * t) / (pi * t);
+            double window = bessel_i0(alpha * std::sqrt(1.0 - (t / radius) * (t / radius))) / bessel_i0(alpha);
+            raw[k] = sinc * window;
+            sum += raw[k];
+        }
+        for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+            result[k] = static_cast<float>(raw[k] / sum);
+        }
+        return result;
+    }();
+    return weights;
+}
+
+struct ColorTables
+{
+    // 8 bit to float per channel (channel * 256 + value), with alpha always linear
+    float srgb_decode[4 * 256];
+    float linear_decode[4 * 256];
+    // indexed by a linear value scaled to FROM_LINEAR_SIZE - 1
+    uint8_t from_linear[FROM_LINEAR_SIZE];
+};
+
+static const ColorTables& color_tables()
+{
+    static const ColorTables tables = []() {
+        ColorTables result{};
+        for (uint32_t c = 0; c < 4; ++c) {
+            for (uint32_t i = 0; i < 256; ++i) {
+                double value = i / 255.0;
+                double linear = value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+                result.srgb_decode[c * 256 + i] = static_cast<float>(c < 3 ? linear : value);
+                result.linear_decode[c * 256 + i] = static_cast<float>(value);
+            }
+        }
+        for (uint32_t i = 0; i < FROM_LINEAR_SIZE; ++i) {
+            double value = static_cast<double>(i) / (FROM_LINEAR_SIZE - 1);
+            double encoded = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+            result.from_linear[i] = static_cast<uint8_t>(std::lround(encoded * 255.0));
+        }
+        return result;
+    }();
+    return tables;
+}
+
+static MipKernel resolve_kernel(MipKernel kernel)
+{
+#if defined(SIMD_X86)
+    const CPUFeatures& features = GetCPUFeatures();
+    if ((kernel == MipKernel::AUTO || kernel == MipKernel::AVX2) && features.avx2 && features.fma) {
+        return MipKernel::AVX2;
+    }
+    // SSE2 is part of x86-64, which is all these kernels need
+    return kernel == MipKernel::SCALAR ? MipKernel::SCALAR : MipKernel::SSE;
+#else
+    (void)kernel;
+    return MipKernel::SCALAR;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------
+// 8 bit <-> float rows
+
+static void decode_texels(const uint8_t* in, uint32_t begin, uint32_t end, const float* table, bool premultiply, float* out)
+{
+    for (uint32_t x = begin; x < end; ++x) {
+        const uint8_t* texel = in + x * 4;
+        float alpha = table[3 * 256 + texel[3]];
+        float scale = premultiply ? alpha : 1.0f;
+        for (uint32_t c = 0; c < 3; ++c) {
+            out[x * 4 + c] = table[c * 256 + texel[c]] * scale;
+        }
+        out[x * 4 + 3] = alpha;
+    }
+}
+
+// the same arithmetic as the SIMD versions, so every kernel rounds identically
+static void encode_texels(const float* in, uint32_t begin, uint32_t end, const MipOptions& options, uint8_t* out)
+{
+    const uint8_t* from_linear = color_tables().from_linear;
+    const float color_scale = options.srgb ? static_cast<float>(FROM_LINEAR_SIZE - 1) : 255.0f;
+    for (uint32_t x = begin; x < end; ++x) {
+        // the Kaiser filter's negative lobes can overshoot at hard edges
+        float alpha = std::min(std::max(in[x * 4 + 3], 0.0f), 1.0f);
+        float inverse = 1.0f;
+        if (options.premultiply_alpha) {
+            inverse = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+        }
+        for (uint32_t c = 0; c < 3; ++c) {
+            float value = std::min(std::max(in[x * 4 + c] * inverse, 0.0f), 1.0f);
+            uint32_t quantized = static_cast<uint32_t>(value * color_scale + 0.5f);
+            out[x * 4 + c] = options.srgb ? from_linear[quantized] : static_cast<uint8_t>(quantized);
+        }
+        out[x * 4 + 3] = static_cast<uint8_t>(static_cast<uint32_t>(alpha * 255.0f + 0.5f));
+    }
+}
+
+#if defined(SIMD_X86)
+// stores the quantized lanes of `count` texels; only the color channels of sRGB data go through the table
+static void store_quantized(const int32_t* lanes, uint32_t count, bool srgb, uint8_t* out)
+{
+    const uint8_t* from_linear = color_tables().from_linear;
+    for (uint32_t i = 0; i < count * 4; ++i) {
+        out[i] = srgb && (i & 3) != 3 ? from_linear[lanes[i]] : static_cast<uint8_t>(lanes[i]);
+    }
+}
+
+static uint32_t encode_texels_sse(const float* in, uint32_t begin, uint32_t end, const MipOptions& options, uint8_t* out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const float color_scale = options.srgb ? static_cast<float>(FROM_LINEAR_SIZE - 1) : 255.0f;
+    const __m128 scale = _mm_setr_ps(color_scale, color_scale, color_scale, 255.0f);
+    const __m128 color_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    alignas(16) int32_t lanes[4];
+    for (uint32_t x = begin; x < end; ++x) {
+        __m128 texel = _mm_loadu_ps(in + x * 4);
+        __m128 alpha = _mm_min_ps(_mm_max_ps(_mm_shuffle_ps(texel, texel, _MM_SHUFFLE(3, 3, 3, 3)), zero), one);
+        if (options.premultiply_alpha) {
+            texel = _mm_mul_ps(texel, _mm_and_ps(_mm_div_ps(one, alpha), _mm_cmpgt_ps(alpha, zero)));
+        }
+        texel = _mm_or_ps(_mm_and_ps(color_mask, texel), _mm_andnot_ps(color_mask, alpha));
+        texel = _mm_min_ps(_mm_max_ps(texel, zero), one);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(texel, scale), half)));
+        store_quantized(lanes, 1, options.srgb, out + x * 4);
+    }
+    return end;
+}
+
+SIMD_TARGET_AVX2 static uint32_t encode_texels_avx2(const float* in, uint32_t begin, uint32_t end, const MipOptions& options,
+    uint8_t* out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const float color_scale = options.srgb ? static_cast<float>(FROM_LINEAR_SIZE - 1) : 255.0f;
+    const __m256 scale = _mm256_setr_ps(color_scale, color_scale, color_scale, 255.0f, color_scale, color_scale, color_scale, 255.0f);
+    alignas(32) int32_t lanes[8];
+    uint32_t x = begin;
+    for (; x + 2 <= end; x += 2) {
+        __m256 texels = _mm256_loadu_ps(in + x * 4);
+        __m256 alpha = _mm256_min_ps(_mm256_max_ps(_mm256_permute_ps(texels, _MM_SHUFFLE(3, 3, 3, 3)), zero), one);
+        if (options.premultiply_alpha) {
+            texels = _mm256_mul_ps(texels, _mm256_and_ps(_mm256_div_ps(one, alpha), _mm256_cmp_ps(alpha, zero, _CMP_GT_OQ)));
+        }
+        texels = _mm256_min_ps(_mm256_max_ps(_mm256_blend_ps(texels, alpha, 0x88), zero), one);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(texels, scale), half)));
+        store_quantized(lanes, 2, options.srgb, out + x * 4);
+    }
+    return x;
+}
+
+// two texels per gather: the byte plus its channel's table offset indexes all four tables at once
+SIMD_TARGET_AVX2 static uint32_t decode_texels_avx2(const uint8_t* in, uint32_t begin, uint32_t end, const float* table,
+    bool premultiply, float* out)
+{
+    const __m256i channel_offsets = _mm256_setr_epi32(0, 256, 512, 768, 0, 256, 512, 768);
+    uint32_t x = begin;
+    for (; x + 2 <= end; x += 2) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + x * 4));
+        __m256 texels = _mm256_i32gather_ps(table, _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), channel_offsets), 4);
+        if (premultiply) {
+            __m256 alpha = _mm256_permute_ps(texels, _MM_SHUFFLE(3, 3, 3, 3));
+            texels = _mm256_blend_ps(_mm256_mul_ps(texels, alpha), texels, 0x88);
+        }
+        _mm256_storeu_ps(out + x * 4, texels);
+    }
+    return x;
+}
+#endif
+
+static void decode_row(const uint8_t* in, uint32_t width, const MipOptions& options, MipKernel kernel, float* out)
+{
+    const ColorTables& tables = color_tables();
+    const float* table = options.srgb ? tables.srgb_decode : tables.linear_decode;
+    uint32_t x = 0;
+#if defined(SIMD_X86)
+    if (kernel == MipKernel::AVX2) {
+        x = decode_texels_avx2(in, x, width, table, options.premultiply_alpha, out);
+    }
+#else
+    (void)kernel;
+#endif
+    decode_texels(in, x, width, table, options.premultiply_alpha, out);
+}
+
+static void encode_row(const float* in, uint32_t width, const MipOptions& options, MipKernel kernel, uint8_t* out)
+{
+    uint32_t x = 0;
+#if defined(SIMD_X86)
+    if (kernel == MipKernel::AVX2) {
+        x = encode_texels_avx2(in, x, width, options, out);
+    }
+    if (kernel != MipKernel::SCALAR) {
+        x = encode_texels_sse(in, x, width, options, out);
+    }
+#else
+    (void)kernel;
+#endif
+    encode_texels(in, x, width, options, out);
+}
+
+// Hands the filters float rows of the level being reduced. Level 0 is decoded from 8 bit into
+// a two row ring as the filters ask for rows, which they do in increasing order; the float
+// levels below it are read in place.
+class RowSource
+{
+public:
+    RowSource(const float* texels, uint32_t width)
+        : texels_(texels), rgba_(nullptr), width_(width), options_(nullptr), kernel_(MipKernel::SCALAR)
+    {
+    }
+
+    RowSource(const uint8_t* rgba, uint32_t width, const MipOptions& options, MipKernel kernel)
+        : texels_(nullptr), rgba_(rgba), width_(width), options_(&options), kernel_(kernel), ring_(width * 4 * 2),
+          ring_rows_{UINT32_MAX, UINT32_MAX}
+    {
+    }
+
+    const float* Row(uint32_t y)
+    {
+        if (texels_) {
+            return texels_ + static_cast<size_t>(y) * width_ * 4;
+        }
+        float* slot = ring_.data() + (y & 1) * width_ * 4;
+        if (ring_rows_[y & 1] != y) {
+            decode_row(rgba_ + static_cast<size_t>(y) * width_ * 4, width_, *options_, kernel_, slot);
+            ring_rows_[y & 1] = y;
+        }
+        return slot;
+    }
+
+private:
+    const float* texels_;
+    const uint8_t* rgba_;
+    uint32_t width_;
+    const MipOptions* options_;
+    MipKernel kernel_;
+    AlignedFloats ring_;
+    uint32_t ring_rows_[2];
+};
+
+// ---------------------------------------------------------------------------------------------
+// box
+
+static void box_texel(const float* row0, const float* row1, uint32_t width, uint32_t x, float* out)
+{
+    uint32_t x0 = std::min(x * 2, width - 1);
+    uint32_t x1 = std::min(x * 2 + 1, width - 1);
+    for (int32_t c = 0; c < 4; ++c) {
+        out[c] = 0.25f * (row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c]);
+    }
+}
+
+#if defined(SIMD_X86)
+static uint32_t box_row_sse(const float* row0, const float* row1, uint32_t begin, uint32_t end, float* out)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (uint32_t x = begin; x < end; ++x) {
+        __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+        __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+        _mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+    }
+    return end;
+}
+
+// two output texels per iteration: sum the rows, then add the two texels of each source pair
+SIMD_TARGET_AVX2 static uint32_t box_row_avx2(const float* row0, const float* row1, uint32_t begin, uint32_t end, float* out)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    uint32_t x = begin;
+    for (; x + 2 <= end; x += 2) {
+        __m256 first = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+        __m256 second = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+        __m256 left = _mm256_permute2f128_ps(first, second, 0x20);
+        __m256 right = _mm256_permute2f128_ps(first, second, 0x31);
+        _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(left, right), quarter));
+    }
+    return x;
+}
+#endif
+
+static void box_downsample(RowSource& source, uint32_t width, uint32_t height, float* dst, MipKernel kernel)
+{
+    uint32_t next_width = std::max(1u, width / 2);
+    uint32_t next_height = std::max(1u, height / 2);
+    // texels whose 2x2 footprint is inside the row; an odd last column is clamped
+    uint32_t full = width / 2;
+    for (uint32_t y = 0; y < next_height; ++y) {
+        const float* row0 = source.Row(std::min(y * 2, height - 1));
+        const float* row1 = source.Row(std::min(y * 2 + 1, height - 1));
+        float* out = dst + static_cast<size_t>(y) * next_width * 4;
+        uint32_t x = 0;
+#if defined(SIMD_X86)
+        if (kernel == MipKernel::AVX2) {
+            x = box_row_avx2(row0, row1, x, full, out);
+        }
+        if (kernel != MipKernel::SCALAR) {
+            x = box_row_sse(row0, row1, x, full, out);
+        }
+#else
+        (void)kernel;
+        (void)full;
+#endif
+        for (; x < next_width; ++x) {
+            box_texel(row0, row1, width, x, out + x * 4);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Kaiser, separable: a horizontal pass into a half-width buffer, then a vertical one
+
+static void kaiser_texel(const float* row, uint32_t width, uint32_t x, const KaiserWeights& weights, float* out)
+{
+    float sum[4] = {};
+    for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+        int32_t source = std::clamp(static_cast<int32_t>(x * 2) + k + KAISER_FIRST_TAP, 0, static_cast<int32_t>(width) - 1);
+        for (int32_t c = 0; c < 4; ++c) {
+            sum[c] += weights[k] * row[source * 4 + c];
+        }
+    }
+    for (int32_t c = 0; c < 4; ++c) {
+        out[c] = sum[c];
+    }
+}
+
+#if defined(SIMD_X86)
+static uint32_t kaiser_row_sse(const float* row, uint32_t begin, uint32_t end, const KaiserWeights& weights, float* out)
+{
+    __m128 w[KAISER_TAPS];
+    for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+        w[k] = _mm_set1_ps(weights[k]);
+    }
+    for (uint32_t x = begin; x < end; ++x) {
+        const float* taps = row + (static_cast<int32_t>(x * 2) + KAISER_FIRST_TAP) * 4;
+        __m128 sum = _mm_mul_ps(w[0], _mm_loadu_ps(taps));
+        for (int32_t k = 1; k < KAISER_TAPS; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(w[k], _mm_loadu_ps(taps + k * 4)));
+        }
+        _mm_storeu_ps(out + x * 4, sum);
+    }
+    return end;
+}
+
+// two output texels per iteration; their taps are two source texels apart
+SIMD_TARGET_AVX2 static uint32_t kaiser_row_avx2(const float* row, uint32_t begin, uint32_t end, const KaiserWeights& weights,
+    float* out)
+{
+    __m256 w[KAISER_TAPS];
+    for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+        w[k] = _mm256_set1_ps(weights[k]);
+    }
+    uint32_t x = begin;
+    for (; x + 2 <= end; x += 2) {
+        const float* taps = row + (static_cast<int32_t>(x * 2) + KAISER_FIRST_TAP) * 4;
+        __m256 sum = _mm256_setzero_ps();
+        for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+            __m256 pair = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(taps + k * 4)), _mm_loadu_ps(taps + k * 4 + 8), 1);
+            sum = _mm256_fmadd_ps(w[k], pair, sum);
+        }
+        _mm256_storeu_ps(out + x * 4, sum);
+    }
+    return x;
+}
+
+// the vertical pass weights whole rows, so it runs over floats regardless of texel boundaries
+static size_t kaiser_rows_sse(const float* const rows[KAISER_TAPS], size_t begin, size_t count, const KaiserWeights& weights,
+    float* out)
+{
+    size_t i = begin;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+        for (int32_t k = 1; k < KAISER_TAPS; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        }
+        _mm_storeu_ps(out + i, sum);
+    }
+    return i;
+}
+
+SIMD_TARGET_AVX2 static size_t kaiser_rows_avx2(const float* const rows[KAISER_TAPS], size_t begin, size_t count,
+    const KaiserWeights& weights, float* out)
+{
+    size_t i = begin;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i), sum);
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+    return i;
+}
+#endif
+
+static void kaiser_horizontal(const float* row, uint32_t width, MipKernel kernel, float* out)
+{
+    const KaiserWeights& weights = kaiser_weights();
+    uint32_t next_width = std::max(1u, width / 2);
+    // taps stay inside the row from texel 2 up to the last one whose rightmost tap 2x + 4 fits
+    uint32_t inner_begin = std::min(2u, next_width);
+    uint32_t inner_end = width >= 5 ? std::clamp((width - 5) / 2 + 1, inner_begin, next_width) : inner_begin;
+    uint32_t x = 0;
+    for (; x < inner_begin; ++x) {
+        kaiser_texel(row, width, x, weights, out + x * 4);
+    }
+#if defined(SIMD_X86)
+    if (kernel == MipKernel::AVX2) {
+        x = kaiser_row_avx2(row, x, inner_end, weights, out);
+    }
+    if (kernel != MipKernel::SCALAR) {
+        x = kaiser_row_sse(row, x, inner_end, weights, out);
+    }
+#else
+    (void)kernel;
+    (void)inner_end;
+#endif
+    for (; x < next_width; ++x) {
+        kaiser_texel(row, width, x, weights, out + x * 4);
+    }
+}
+
+static void kaiser_downsample(RowSource& source, uint32_t width, uint32_t height, float* dst, MipKernel kernel)
+{
+    const KaiserWeights& weights = kaiser_weights();
+    uint32_t next_width = std::max(1u, width / 2);
+    uint32_t next_height = std::max(1u, height / 2);
+    size_t row_floats = static_cast<size_t>(next_width) * 4;
+
+    // Horizontally filtered rows, kept for the eight source rows the current output row needs.
+    // Those are consecutive, so they never share a slot, and each is filtered exactly once.
+    AlignedFloats ring(row_floats * KAISER_TAPS);
+    uint32_t ring_rows[KAISER_TAPS];
+    std::fill(std::begin(ring_rows), std::end(ring_rows), UINT32_MAX);
+
+    for (uint32_t y = 0; y < next_height; ++y) {
+        const float* rows[KAISER_TAPS];
+        for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+            uint32_t row = static_cast<uint32_t>(
+                std::clamp(static_cast<int32_t>(y * 2) + k + KAISER_FIRST_TAP, 0, static_cast<int32_t>(height) - 1));
+            uint32_t slot = row % KAISER_TAPS;
+            if (ring_rows[slot] != row) {
+                kaiser_horizontal(source.Row(row), width, kernel, ring.data() + slot * row_floats);
+                ring_rows[slot] = row;
+            }
+            rows[k] = ring.data() + slot * row_floats;
+        }
+        float* out = dst + y * row_floats;
+        size_t i = 0;
+#if defined(SIMD_X86)
+        if (kernel == MipKernel::AVX2) {
+            i = kaiser_rows_avx2(rows, i, row_floats, weights, out);
+        }
+        if (kernel != MipKernel::SCALAR) {
+            i = kaiser_rows_sse(rows, i, row_floats, weights, out);
+        }
+#endif
+        for (; i < row_floats; ++i) {
+            float sum = 0.0f;
+            for (int32_t k = 0; k < KAISER_TAPS; ++k) {
+                sum += weights[k] * rows[k][i];
+            }
+            out[i] = sum;
+        }
+    }
+}
+
+std::vector<MipLevel> GenerateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, const MipOptions& options)
+{
+    MipKernel kernel = resolve_kernel(options.kernel);
+    std::vector<MipLevel> levels;
+    if (width <= 1 && height <= 1) {
+        return levels;
+    }
+
+    // levels alternate between two float buffers sized for levels 1 and 2
+    AlignedFloats buffers[2];
+    buffers[0].resize(static_cast<size_t>(std::max(1u, width / 2)) * std::max(1u, height / 2) * 4);
+    buffers[1].resize(static_cast<size_t>(std::max(1u, width / 4)) * std::max(1u, height / 4) * 4);
+    RowSource top{rgba, width, options, kernel};
+    const float* previous = nullptr;
+    while (width > 1 || height > 1) {
+        uint32_t next_width = std::max(1u, width / 2);
+        uint32_t next_height = std::max(1u, height / 2);
+        float* next = buffers[levels.size() % 2].data();
+        RowSource below{previous, width};
+        RowSource& source = previous ? below : top;
+        if (options.filter == MipFilter::BOX) {
+            box_downsample(source, width, height, next, kernel);
+        } else {
+            kaiser_downsample(source, width, height, next, kernel);
+        }
+
+        MipLevel level{next_width, next_height, std::vector<uint8_t>(static_cast<size_t>(next_width) * next_height * 4)};
+        for (uint32_t y = 0; y < next_height; ++y) {
+            size_t offset = static_cast<size_t>(y) * next_width * 4;
+            encode_row(next + offset, next_width, options, kernel, level.rgba.data() + offset);
+        }
+        levels.push_back(std::move(level));
+        previous = next;
+        width = next_width;
+        height = next_height;
+    }
+    return levels;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum class MipFilter
+{
+    // 2x2 average, what glGenerateMipmap does on most drivers
+    BOX,
+    // 8 tap Kaiser-windowed sinc per axis; keeps distant levels sharper than repeated box filtering
+    KAISER,
+};
+
+enum class MipKernel
+{
+    // the widest the CPU supports
+    AUTO,
+    SCALAR,
+    SSE,
+    // needs AVX2 and FMA, falls back to SSE otherwise
+    AVX2,
+};
+
+struct MipOptions
+{
+    MipFilter filter = MipFilter::KAISER;
+    // the color channels are sRGB encoded: filter in linear light and encode the result again
+    bool srgb = true;
+    // weight color by alpha while filtering, so the color of transparent texels doesn't bleed
+    // into visible ones; levels are stored with straight alpha again afterwards
+    bool premultiply_alpha = false;
+    MipKernel kernel = MipKernel::AUTO;
+};
+
+struct MipLevel
+{
+    uint32_t width;
+    uint32_t height;
+    // RGBA8, rows tightly packed
+    std::vector<uint8_t> rgba;
+};
+
+// Builds the mip chain of an RGBA8 image below level 0, down to 1x1, with the level sizes
+// glGenerateMipmap uses (each dimension halved and rounded down). Each level is filtered from
+// the previous one in float, so rounding to 8 bit happens once per level rather than
+// compounding down the chain. Level 0 is decoded to float a few rows at a time, so only the
+// levels below it are ever held in float. The filters and the conversions back to 8 bit run on
+// SSE or AVX2 with one RGBA texel per 128 bit lane.
+std::vector<MipLevel> GenerateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, const MipOptions& options = {});
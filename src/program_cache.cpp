@@ -0,0 +1,166 @@
+#include "program_cache.h"
+#include "gl_extensions.h"
+#include "hash.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+ProgramBinaryCache program_cache{};
+
+static constexpr uint32_t CACHE_MAGIC = 0x42504F4C; // "LOPB"
+static constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+static std::string gl_string(uint32_t name)
+{
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
+void ProgramBinaryCache::Initialize(const std::filesystem::path& directory)
+{
+    directory_ = directory;
+    driver_ = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+    supported_ = gl_capabilities.program_binary;
+    if (enabled_ && supported_) {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        if (error) {
+            std::cout << "Program cache: cannot create " << directory_ << ": " << error.message() << std::endl;
+            supported_ = false;
+        }
+    }
+}
+
+void ProgramBinaryCache::SetEnabled(bool enabled)
+{
+    enabled_ = enabled;
+}
+
+bool ProgramBinaryCache::IsEnabled() const
+{
+    return enabled_ && supported_;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(std::string_view vert_code, std::string_view frag_code) const
+{
+    // the separators keep "ab" + "c" and "a" + "bc" apart
+    uint64_t hash = Fnv1a64(driver_);
+    hash = Fnv1a64(std::string_view{"\0", 1}, hash);
+    hash = Fnv1a64(vert_code, hash);
+    hash = Fnv1a64(std::string_view{"\0", 1}, hash);
+    return Fnv1a64(frag_code, hash);
+}
+
+bool ProgramBinaryCache::Load(uint64_t key, uint32_t program_id)
+{
+    if (!IsEnabled()) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::filesystem::path path = EntryPath(key);
+    std::ifstream file{path, std::ios::binary};
+    CacheHeader header{};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CACHE_MAGIC ||
+        header.version != CACHE_VERSION || header.key != key) {
+        ++misses_;
+        return false;
+    }
+    std::vector<char> blob(header.length);
+    if (!file.read(blob.data(), static_cast<std::streamsize>(blob.size()))) {
+        ++misses_;
+        return false;
+    }
+    file.close();
+
+    glProgramBinary(program_id, header.format, blob.data(), static_cast<int32_t>(blob.size()));
+    int32_t success = 0;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+    if (!success) {
+        // usually a driver update that kept the version string; drop the entry so it gets rebuilt
+        ++rejected_;
+        ++misses_;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    ++hits_;
+    load_ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, uint32_t program_id)
+{
+    if (!IsEnabled()) {
+        return;
+    }
+    int32_t length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> blob(static_cast<size_t>(length));
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, key, 0, 0};
+    int32_t written = 0;
+    glGetProgramBinary(program_id, length, &written, &header.format, blob.data());
+    if (written <= 0) {
+        return;
+    }
+    header.length = static_cast<uint32_t>(written);
+
+    // write next to the entry and rename, so a crash never leaves a truncated blob behind
+    std::filesystem::path path = EntryPath(key);
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(blob.data(), written);
+        if (!file) {
+            std::cout << "Program cache: failed to write " << temp_path << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+void ProgramBinaryCache::RecordCompile(double ms)
+{
+    compile_ms_ += ms;
+}
+
+void ProgramBinaryCache::PrintStats() const
+{
+    if (!IsEnabled()) {
+        std::cout << "Program cache: " << (enabled_ ? "not supported by the driver" : "disabled") << ", " << compile_ms_
+                  << " ms compiling" << std::endl;
+        return;
+    }
+    std::cout << "Program cache: " << hits_ << " hits (" << load_ms_ << " ms loading), " << misses_ << " misses ("
+              << compile_ms_ << " ms compiling), " << rejected_ << " rejected by the driver" << std::endl;
+}
+
+std::filesystem::path ProgramBinaryCache::EntryPath(uint64_t key) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return directory_ / name.str();
+}
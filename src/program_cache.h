@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// On-disk cache of linked program binaries (ARB_get_program_binary). Entries are keyed by a
+// hash of the shader sources and the driver vendor/renderer/version strings, so a driver
+// update or an edited shader simply misses. A blob the driver refuses is deleted and the
+// caller falls back to a full compile.
+class ProgramBinaryCache
+{
+public:
+    // reads the driver identity; call with the context current, after LoadGLExtensions
+    void Initialize(const std::filesystem::path& directory);
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    uint64_t MakeKey(std::string_view vert_code, std::string_view frag_code) const;
+    // true when program_id now holds a linked program restored from the cache
+    bool Load(uint64_t key, uint32_t program_id);
+    // program_id must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    void Store(uint64_t key, uint32_t program_id);
+    void RecordCompile(double ms);
+    void PrintStats() const;
+
+private:
+    std::filesystem::path EntryPath(uint64_t key) const;
+
+private:
+    std::filesystem::path directory_;
+    std::string driver_;
+    bool enabled_ = true;
+    bool supported_ = false;
+
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+    uint32_t rejected_ = 0;
+    double load_ms_ = 0.0;
+    double compile_ms_ = 0.0;
+};
+
+extern ProgramBinaryCache program_cache;
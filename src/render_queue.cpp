@@ -0,0 +1,153 @@
+#include "render_queue.h"
+#include "shader.h"
+#include "gl_state_cache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+uint64_t RenderKey::Make(uint32_t pass, bool translucent, float depth, uint32_t program, uint32_t material, uint32_t mesh)
+{
+    constexpr uint32_t max_depth = (1u << DEPTH_BITS) - 1;
+    uint32_t depth_bits = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(max_depth));
+    if (translucent) {
+        depth_bits = max_depth - depth_bits;
+    } else {
+        depth_bits &= 0xE000u;
+    }
+    return (static_cast<uint64_t>(pass) << PASS_SHIFT) |
+        (static_cast<uint64_t>(translucent ? 1 : 0) << TRANSLUCENT_SHIFT) |
+        (static_cast<uint64_t>(depth_bits) << DEPTH_SHIFT) |
+        (static_cast<uint64_t>(program) << PROGRAM_SHIFT) |
+        (static_cast<uint64_t>(material) << MATERIAL_SHIFT) |
+        (static_cast<uint64_t>(mesh) << MESH_SHIFT);
+}
+
+static constexpr UniformName MODEL_UNIFORM{"model"};
+static constexpr UniformName MATERIAL_UNIFORM{"materialIndex"};
+
+uint32_t RenderQueue::RegisterProgram(Shader* shader)
+{
+    if (programs_.size() >= (1u << RenderKey::PROGRAM_BITS)) {
+        throw std::runtime_error("RenderQueue: too many programs");
+    }
+    programs_.push_back(shader);
+    model_uniforms_.push_back(shader->GetUniform(MODEL_UNIFORM));
+    material_uniforms_.push_back(shader->GetUniform(MATERIAL_UNIFORM));
+    return static_cast<uint32_t>(programs_.size() - 1);
+}
+
+uint32_t RenderQueue::RegisterMaterial(const Material& material)
+{
+    if (materials_.size() >= (1u << RenderKey::MATERIAL_BITS)) {
+        throw std::runtime_error("RenderQueue: too many materials");
+    }
+    materials_.push_back(material);
+    return static_cast<uint32_t>(materials_.size() - 1);
+}
+
+void RenderQueue::SetMaterial(uint32_t material_id, const Material& material)
+{
+    materials_.at(material_id) = material;
+}
+
+uint32_t RenderQueue::RegisterMesh(const MeshRange& mesh)
+{
+    if (meshes_.size() >= (1u << RenderKey::MESH_BITS)) {
+        throw std::runtime_error("RenderQueue: too many meshes");
+    }
+    meshes_.push_back(mesh);
+    return static_cast<uint32_t>(meshes_.size() - 1);
+}
+
+void RenderQueue::Push(uint64_t key, const glm::mat4& model)
+{
+    items_.push_back(SortItem{key, static_cast<uint32_t>(models_.size())});
+    models_.push_back(model);
+}
+
+void RenderQueue::Sort()
+{
+    // LSD radix sort, one byte per pass; a pass is skipped when every key has the same digit there
+    scratch_.resize(items_.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<uint32_t, 256> counts{};
+        for (const SortItem& item : items_) {
+            ++counts[(item.key >> shift) & 0xFF];
+        }
+        if (std::any_of(counts.begin(), counts.end(), [this](uint32_t count) { return count == items_.size(); })) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& count : counts) {
+            uint32_t bucket_size = count;
+            count = offset;
+            offset += bucket_size;
+        }
+        for (const SortItem& item : items_) {
+            scratch_[counts[(item.key >> shift) & 0xFF]++] = item;
+        }
+        items_.swap(scratch_);
+    }
+}
+
+void RenderQueue::Submit()
+{
+    stats_ = Stats{};
+    // sentinels so the first draw always binds everything
+    uint32_t current_program = UINT32_MAX;
+    uint32_t current_material = UINT32_MAX;
+    uint32_t current_vao = UINT32_MAX;
+    Material bound{};
+    bound.textures.fill(UINT32_MAX);
+
+    for (const SortItem& item : items_) {
+        uint32_t program = RenderKey::ProgramId(item.key);
+        uint32_t material = RenderKey::MaterialId(item.key);
+        const MeshRange& mesh = meshes_[RenderKey::MeshId(item.key)];
+
+        bool program_changed = program != current_program;
+        if (program_changed) {
+            programs_[program]->Use();
+            current_program = program;
+            ++stats_.program_changes;
+        }
+        bool material_changed = material != current_material;
+        if (material_changed) {
+            const Material& next = materials_[material];
+            for (uint32_t unit = 0; unit < MATERIAL_TEXTURE_UNITS; ++unit) {
+                if (next.textures[unit] != bound.textures[unit]) {
+                    gl_state.BindTexture(unit, next.target, next.textures[unit]);
+                    bound.textures[unit] = next.textures[unit];
+                }
+            }
+            current_material = material;
+            ++stats_.material_changes;
+        }
+        // ignored by programs that don't declare it
+        if (material_changed || program_changed) {
+            programs_[program]->setInteger(material_uniforms_[program], static_cast<int32_t>(material));
+        }
+        if (mesh.vao != current_vao) {
+            gl_state.BindVertexArray(mesh.vao);
+            current_vao = mesh.vao;
+            ++stats_.mesh_changes;
+        }
+        programs_[program]->setMatrix4(model_uniforms_[program], models_[item.index]);
+        programs_[program]->Flush();
+        glDrawArrays(GL_TRIANGLES, static_cast<int32_t>(mesh.first), static_cast<int32_t>(mesh.count));
+        ++stats_.draws;
+    }
+}
+
+void RenderQueue::Clear()
+{
+    items_.clear();
+    models_.clear();
+}
+
+const RenderQueue::Stats& RenderQueue::GetStats() const
+{
+    return stats_;
+}
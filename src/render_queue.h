@@ -0,0 +1,107 @@
+#pragma once
+
+#include "shader.h"
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <array>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+inline constexpr uint32_t MATERIAL_TEXTURE_UNITS = 2;
+
+struct Material
+{
+    std::array<uint32_t, MATERIAL_TEXTURE_UNITS> textures;
+    uint32_t target = GL_TEXTURE_2D;
+};
+
+struct MeshRange
+{
+    uint32_t vao;
+    uint32_t first;
+    uint32_t count;
+};
+
+// 64-bit draw sort key, most significant field first:
+//   pass (4) | translucent (1) | depth (16) | program (10) | material (16) | mesh (10) | unused (7)
+// Translucent items keep full depth precision, inverted so they sort back to front. Opaque items
+// only get 8 coarse front-to-back buckets so draws sharing a program and material still end up
+// next to each other.
+struct RenderKey
+{
+    static constexpr uint32_t PASS_BITS = 4;
+    static constexpr uint32_t DEPTH_BITS = 16;
+    static constexpr uint32_t PROGRAM_BITS = 10;
+    static constexpr uint32_t MATERIAL_BITS = 16;
+    static constexpr uint32_t MESH_BITS = 10;
+
+    static constexpr uint32_t MESH_SHIFT = 7;
+    static constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+    static constexpr uint32_t PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    static constexpr uint32_t DEPTH_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+    static constexpr uint32_t TRANSLUCENT_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    static constexpr uint32_t PASS_SHIFT = TRANSLUCENT_SHIFT + 1;
+
+    // depth is the normalized view distance in [0, 1]
+    static uint64_t Make(uint32_t pass, bool translucent, float depth, uint32_t program, uint32_t material, uint32_t mesh);
+
+    static uint32_t ProgramId(uint64_t key) { return Field(key, PROGRAM_SHIFT, PROGRAM_BITS); }
+    static uint32_t MaterialId(uint64_t key) { return Field(key, MATERIAL_SHIFT, MATERIAL_BITS); }
+    static uint32_t MeshId(uint64_t key) { return Field(key, MESH_SHIFT, MESH_BITS); }
+
+private:
+    static uint32_t Field(uint64_t key, uint32_t shift, uint32_t bits)
+    {
+        return static_cast<uint32_t>((key >> shift) & ((uint64_t{1} << bits) - 1));
+    }
+};
+
+// Draws are pushed in any order with a RenderKey, sorted with an LSD radix sort and then submitted
+// so that program, texture and VAO changes are only emitted when the corresponding key field
+// differs from the previous draw. Programs that declare a materialIndex uniform get the material
+// id of every draw, for materials whose textures are layers of a shared array.
+class RenderQueue
+{
+public:
+    struct Stats
+    {
+        uint32_t draws;
+        uint32_t program_changes;
+        uint32_t material_changes;
+        uint32_t mesh_changes;
+    };
+
+public:
+    uint32_t RegisterProgram(Shader* shader);
+    uint32_t RegisterMaterial(const Material& material);
+    // replaces the textures of a registered material, e.g. once they have been packed
+    void SetMaterial(uint32_t material_id, const Material& material);
+    uint32_t RegisterMesh(const MeshRange& mesh);
+
+    void Push(uint64_t key, const glm::mat4& model);
+    void Sort();
+    void Submit();
+    void Clear();
+
+    const Stats& GetStats() const;
+
+private:
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<Shader*> programs_;
+    std::vector<UniformHandle> model_uniforms_;
+    std::vector<UniformHandle> material_uniforms_;
+    std::vector<Material> materials_;
+    std::vector<MeshRange> meshes_;
+    std::vector<SortItem> items_;
+    std::vector<SortItem> scratch_;
+    std::vector<glm::mat4> models_;
+    Stats stats_{};
+};
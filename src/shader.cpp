@@ -1,7 +1,17 @@
 #include "shader.h"
+#include "trace.h"
+#include "gl_state_cache.h"
+#include "gl_extensions.h"
+#include "program_cache.h"
+#include "frame_constants.h"
+#include "shader_preprocessor.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <iterator>
+#include <regex>
 #include <iostream>
 
 #include <glad/glad.h>
@@ -9,102 +19,675 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const std::filesystem::path& vert_path, const std::filesystem::path& frag_path)
+static constexpr uint32_t INVALID_UNIFORM = UINT32_MAX;
+
+static Shader::UniformStats uniform_stats{};
+
+// bytes per array element in the shadow; everything not listed is a 32-bit int or a sampler
+static uint32_t uniform_size(uint32_t type)
 {
-    std::string vert_code = ReadShaderFile(vert_path);
-    std::string frag_code = ReadShaderFile(frag_path);
-    uint32_t vertex = CompileShader(vert_code, GL_VERTEX_SHADER);
-    uint32_t fragment = CompileShader(frag_code, GL_FRAGMENT_SHADER);
-    program_id_ = glCreateProgram();
-    glAttachShader(program_id_, vertex);
-    glAttachShader(program_id_, fragment);
-    glLinkProgram(program_id_);
+    switch (type) {
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+    case GL_UNSIGNED_INT_VEC2:
+        return 8;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+    case GL_UNSIGNED_INT_VEC3:
+        return 12;
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+    case GL_UNSIGNED_INT_VEC4:
+    case GL_FLOAT_MAT2:
+        return 16;
+    case GL_FLOAT_MAT2x3:
+    case GL_FLOAT_MAT3x2:
+        return 24;
+    case GL_FLOAT_MAT2x4:
+    case GL_FLOAT_MAT4x2:
+        return 32;
+    case GL_FLOAT_MAT3:
+        return 36;
+    case GL_FLOAT_MAT3x4:
+    case GL_FLOAT_MAT4x3:
+        return 48;
+    case GL_FLOAT_MAT4:
+        return 64;
+    default:
+        return 4;
+    }
+}
 
-    int32_t success = 0;
-    char info_log[512];
-    glGetProgramiv(program_id_, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program_id_, 512, nullptr, info_log);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << info_log << std::endl;
-        throw std::runtime_error("error");
+static bool read_spirv_module(const std::filesystem::path& path, std::string& module)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        std::cout << "No SPIR-V module " << path << ", compiling GLSL" << std::endl;
+        return false;
+    }
+    module.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    return !module.empty();
+}
+
+// (location, name) of every `UNIFORM_LOCATION(n) uniform type name` declaration in the source
+static std::vector<std::pair<int32_t, std::string>> find_uniform_locations(const std::string& code)
+{
+    static const std::regex declaration{R"(UNIFORM_LOCATION\(\s*(\d+)\s*\)\s*uniform\s+\w+\s+(\w+))"};
+    std::vector<std::pair<int32_t, std::string>> uniforms;
+    for (auto it = std::sregex_iterator{code.begin(), code.end(), declaration}; it != std::sregex_iterator{}; ++it) {
+        uniforms.emplace_back(std::stoi((*it)[1].str()), (*it)[2].str());
+    }
+    return uniforms;
+}
+
+std::filesystem::path SpirvModulePath(const std::filesystem::path& directory, const std::filesystem::path& source,
+    const ShaderDefines& defines)
+{
+    ShaderDefines sorted = defines;
+    std::sort(sorted.begin(), sorted.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+    std::string name = source.filename().string();
+    for (const ShaderDefine& define : sorted) {
+        name += "+" + define.name + (define.value.empty() ? "" : "=" + define.value);
     }
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    return directory / (name + ".spv");
+}
+
+Shader::Shader(const std::filesystem::path& vert_path, const std::filesystem::path& frag_path, const ShaderDefines& defines,
+    ShaderCompile compile)
+    : vert_path_(vert_path), frag_path_(frag_path), defines_(defines), program_id_(0), status_(ShaderStatus::COMPILING), generation_(0)
+{
+    TRACE_SCOPE("Shader::Shader");
+    Start(compile);
+}
+
+Shader::Shader(const SpirvModules& spirv, const std::filesystem::path& vert_path, const std::filesystem::path& frag_path,
+    const ShaderDefines& defines, ShaderCompile compile)
+    : vert_path_(vert_path), frag_path_(frag_path), defines_(defines), spirv_directory_(spirv.directory), program_id_(0),
+      status_(ShaderStatus::COMPILING), generation_(0)
+{
+    TRACE_SCOPE("Shader::Shader");
+    Start(compile);
 }
 
 Shader::~Shader()
 {
+    if (pending_) {
+        DiscardBuild(*pending_);
+    }
+    gl_state.OnProgramDeleted(program_id_);
     glDeleteProgram(program_id_);
 }
 
+bool Shader::IsReady()
+{
+    Poll(false);
+    return status_ == ShaderStatus::READY;
+}
+
+ShaderStatus Shader::GetStatus() const
+{
+    return status_;
+}
+
+void Shader::Reload()
+{
+    TRACE_SCOPE("Shader::Reload");
+    spirv_directory_.reset();
+    if (pending_) {
+        DiscardBuild(*pending_);
+        pending_.reset();
+    }
+    try {
+        pending_ = StartBuild();
+    } catch (const std::exception& e) {
+        // editors briefly remove or truncate files while saving; the next change event retries
+        std::cout << "Shader reload skipped, cannot read sources: " << e.what() << std::endl;
+    }
+}
+
+std::vector<std::filesystem::path> Shader::GetSourcePaths() const
+{
+    return source_files_.empty() ? std::vector<std::filesystem::path>{vert_path_, frag_path_} : source_files_;
+}
+
+const ShaderDefines& Shader::GetDefines() const
+{
+    return defines_;
+}
+
+const Shader::BuildStats& Shader::GetBuildStats() const
+{
+    return build_stats_;
+}
+
+uint32_t Shader::GetGeneration() const
+{
+    return generation_;
+}
 
 void Shader::Use()
 {
-    glUseProgram(program_id_);
+    gl_state.UseProgram(program_id_);
 }
 
-void Shader::setBool(std::string_view name, bool value) const
+UniformHandle Shader::GetUniform(UniformName name)
 {
-    glUniform1i(GetUniformLocation(name), static_cast<int32_t>(value));
+    for (uint32_t i = 0; i < handle_hashes_.size(); ++i) {
+        if (handle_hashes_[i] == name.hash) {
+            return UniformHandle{i};
+        }
+    }
+    handle_hashes_.push_back(name.hash);
+    handle_uniforms_.push_back(FindUniform(name.hash));
+    return UniformHandle{static_cast<uint32_t>(handle_hashes_.size() - 1)};
 }
 
-void Shader::setInteger(std::string_view name, int32_t value) const
+void Shader::setBool(UniformHandle uniform, bool value)
 {
-    glUniform1i(GetUniformLocation(name), value);
+    int32_t data = value ? 1 : 0;
+    SetValue(handle_uniforms_[uniform.index], &data, sizeof(data), 1);
 }
 
-void Shader::setFloat(std::string_view name, float value) const
+void Shader::setInteger(UniformHandle uniform, int32_t value)
 {
-    glUniform1f(GetUniformLocation(name), value);
+    SetValue(handle_uniforms_[uniform.index], &value, sizeof(value), 1);
 }
 
-void Shader::setMatrix4(std::string_view name, const glm::mat4& value) const
+void Shader::setFloat(UniformHandle uniform, float value)
 {
-    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+    SetValue(handle_uniforms_[uniform.index], &value, sizeof(value), 1);
 }
 
-std::string Shader::ReadShaderFile(const std::filesystem::path& file_path) const
+void Shader::setMatrix4(UniformHandle uniform, const glm::mat4& value)
 {
-    std::ifstream shader_file;
-    std::stringstream shader_stream;
-    // ensure ifstream objects can throw exceptions
-    shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit); 
-    try {
-        shader_file.open(file_path);
-        shader_stream << shader_file.rdbuf();
-        shader_file.close();
-    } catch (std::ifstream::failure e) {
-        std::cout << "ERROR::SHADER::FAILED_TO_READ_FILE: " << e.what() << std::endl;
-        throw std::runtime_error(file_path.u8string());
+    SetValue(handle_uniforms_[uniform.index], glm::value_ptr(value), sizeof(value), 1);
+}
+
+void Shader::setBool(std::string_view name, bool value)
+{
+    int32_t data = value ? 1 : 0;
+    SetValue(GetUniformIndex(name), &data, sizeof(data), 1);
+}
+
+void Shader::setInteger(std::string_view name, int32_t value)
+{
+    SetValue(GetUniformIndex(name), &value, sizeof(value), 1);
+}
+
+void Shader::setFloat(std::string_view name, float value)
+{
+    SetValue(GetUniformIndex(name), &value, sizeof(value), 1);
+}
+
+void Shader::setMatrix4(std::string_view name, const glm::mat4& value)
+{
+    SetValue(GetUniformIndex(name), glm::value_ptr(value), sizeof(value), 1);
+}
+
+void Shader::setFloatArray(UniformHandle uniform, std::span<const float> values)
+{
+    SetValue(handle_uniforms_[uniform.index], values.data(), sizeof(float), values.size());
+}
+
+void Shader::setIntegerArray(UniformHandle uniform, std::span<const int32_t> values)
+{
+    SetValue(handle_uniforms_[uniform.index], values.data(), sizeof(int32_t), values.size());
+}
+
+void Shader::setVec4Array(UniformHandle uniform, std::span<const glm::vec4> values)
+{
+    SetValue(handle_uniforms_[uniform.index], values.data(), sizeof(glm::vec4), values.size());
+}
+
+void Shader::setMatrix4Array(UniformHandle uniform, std::span<const glm::mat4> values)
+{
+    SetValue(handle_uniforms_[uniform.index], values.data(), sizeof(glm::mat4), values.size());
+}
+
+void Shader::setFloatArray(std::string_view name, std::span<const float> values)
+{
+    SetValue(GetUniformIndex(name), values.data(), sizeof(float), values.size());
+}
+
+void Shader::setIntegerArray(std::string_view name, std::span<const int32_t> values)
+{
+    SetValue(GetUniformIndex(name), values.data(), sizeof(int32_t), values.size());
+}
+
+void Shader::setVec4Array(std::string_view name, std::span<const glm::vec4> values)
+{
+    SetValue(GetUniformIndex(name), values.data(), sizeof(glm::vec4), values.size());
+}
+
+void Shader::setMatrix4Array(std::string_view name, std::span<const glm::mat4> values)
+{
+    SetValue(GetUniformIndex(name), values.data(), sizeof(glm::mat4), values.size());
+}
+
+void Shader::Flush()
+{
+    for (uint32_t index : dirty_) {
+        UniformInfo& uniform = uniforms_[index];
+        const void* data = shadow_.data() + uniform.offset;
+        auto floats = static_cast<const float*>(data);
+        auto ints = static_cast<const int32_t*>(data);
+        auto uints = static_cast<const uint32_t*>(data);
+        switch (uniform.type) {
+        case GL_FLOAT:
+            glUniform1fv(uniform.location, uniform.upload_count, floats);
+            break;
+        case GL_FLOAT_VEC2:
+            glUniform2fv(uniform.location, uniform.upload_count, floats);
+            break;
+        case GL_FLOAT_VEC3:
+            glUniform3fv(uniform.location, uniform.upload_count, floats);
+            break;
+        case GL_FLOAT_VEC4:
+            glUniform4fv(uniform.location, uniform.upload_count, floats);
+            break;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:
+            glUniform2iv(uniform.location, uniform.upload_count, ints);
+            break;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:
+            glUniform3iv(uniform.location, uniform.upload_count, ints);
+            break;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+            glUniform4iv(uniform.location, uniform.upload_count, ints);
+            break;
+        case GL_UNSIGNED_INT:
+            glUniform1uiv(uniform.location, uniform.upload_count, uints);
+            break;
+        case GL_UNSIGNED_INT_VEC2:
+            glUniform2uiv(uniform.location, uniform.upload_count, uints);
+            break;
+        case GL_UNSIGNED_INT_VEC3:
+            glUniform3uiv(uniform.location, uniform.upload_count, uints);
+            break;
+        case GL_UNSIGNED_INT_VEC4:
+            glUniform4uiv(uniform.location, uniform.upload_count, uints);
+            break;
+        case GL_FLOAT_MAT2:
+            glUniformMatrix2fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT3:
+            glUniformMatrix3fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT4:
+            glUniformMatrix4fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT2x3:
+            glUniformMatrix2x3fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT2x4:
+            glUniformMatrix2x4fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT3x2:
+            glUniformMatrix3x2fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT3x4:
+            glUniformMatrix3x4fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT4x2:
+            glUniformMatrix4x2fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        case GL_FLOAT_MAT4x3:
+            glUniformMatrix4x3fv(uniform.location, uniform.upload_count, GL_FALSE, floats);
+            break;
+        // int, bool and every sampler type
+        default:
+            glUniform1iv(uniform.location, uniform.upload_count, ints);
+            break;
+        }
+        uniform.dirty = false;
+        uniform.upload_count = 0;
+    }
+    uniform_stats.uploads += dirty_.size();
+    dirty_.clear();
+}
+
+void Shader::BindUniformBlock(std::string_view name, uint32_t binding) const
+{
+    uint32_t block_index = glGetUniformBlockIndex(program_id_, std::string{name}.c_str());
+    if (block_index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program_id_, block_index, binding);
+    }
+}
+
+void Shader::Start(ShaderCompile compile)
+{
+    std::sort(defines_.begin(), defines_.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+    pending_ = StartBuild();
+    if (compile == ShaderCompile::BLOCKING) {
+        Poll(true);
+        if (status_ != ShaderStatus::READY) {
+            throw std::runtime_error("error");
+        }
+    }
+}
+
+// #version has to stay the first directive, so the defines go on the line after it. A #line
+// directive restores the original numbering for compiler messages.
+std::string Shader::InjectDefines(const std::string& code) const
+{
+    if (defines_.empty()) {
+        return code;
+    }
+    size_t version = code.find("#version");
+    size_t insert_at = version == std::string::npos ? 0 : code.find('\n', version);
+    insert_at = insert_at == std::string::npos ? code.size() : insert_at + 1;
+    size_t next_line = 1 + static_cast<size_t>(std::count(code.begin(), code.begin() + insert_at, '\n'));
+
+    std::string injected;
+    for (const ShaderDefine& define : defines_) {
+        injected += "#define " + define.name + " " + (define.value.empty() ? "1" : define.value) + "\n";
+    }
+    injected += "#line " + std::to_string(next_line) + "\n";
+
+    std::string result = code;
+    if (insert_at == code.size() && !code.empty() && code.back() != '\n') {
+        injected.insert(0, "\n");
     }
-    return shader_stream.str();
+    result.insert(insert_at, injected);
+    return result;
 }
 
 uint32_t Shader::CompileShader(std::string_view shader_code, uint32_t shader_type) const
 {
-    int32_t success = 0;
-    char info_log[512];
     const char* shader_code_ptr = shader_code.data();
 
     uint32_t shader_id = glCreateShader(shader_type);
     glShaderSource(shader_id, 1, &shader_code_ptr, nullptr);
     glCompileShader(shader_id);
+    return shader_id;
+}
+
+uint32_t Shader::LoadSpirvShader(std::string_view spirv, uint32_t shader_type) const
+{
+    uint32_t shader_id = glCreateShader(shader_type);
+    glShaderBinary(1, &shader_id, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, spirv.data(), static_cast<int32_t>(spirv.size()));
+    // specialization is where the driver validates the module; its result is the compile status
+    glSpecializeShaderARB(shader_id, "main", 0, nullptr, nullptr);
+    return shader_id;
+}
+
+bool Shader::CheckShader(uint32_t shader_id, const std::vector<std::filesystem::path>& files) const
+{
+    int32_t success = 0;
+    char info_log[512];
     glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
     if (!success) {
         glGetShaderInfoLog(shader_id, 512, nullptr, info_log);
         std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << info_log << std::endl;
-        throw std::runtime_error("error");
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::cout << "  source " << i << ": " << files[i].string() << std::endl;
+        }
+        return false;
     }
-    return shader_id;
+    return true;
 }
 
-int32_t Shader::GetUniformLocation(std::string_view name) const
+Shader::ProgramBuild Shader::StartBuild()
 {
-    auto it = location_cache_.find(name);
-    if (it != location_cache_.end()) {
-        return it->second;
+    ProgramBuild build{};
+    ExpandedSource vert_source = shader_preprocessor.Expand(vert_path_);
+    ExpandedSource frag_source = shader_preprocessor.Expand(frag_path_);
+    build.vert_files = std::move(vert_source.files);
+    build.frag_files = std::move(frag_source.files);
+    // recorded before compiling so a broken include is still watched and its fix picked up
+    source_files_ = build.vert_files;
+    for (const std::filesystem::path& file : build.frag_files) {
+        if (std::find(source_files_.begin(), source_files_.end(), file) == source_files_.end()) {
+            source_files_.push_back(file);
+        }
+    }
+    // the binary cache hashes the fully expanded sources, so an edited include or a different
+    // define set misses without any bookkeeping of its own
+    std::string vert_code = InjectDefines(vert_source.code);
+    std::string frag_code = InjectDefines(frag_source.code);
+    std::string vert_spirv;
+    std::string frag_spirv;
+    if (spirv_directory_ && gl_capabilities.gl_spirv) {
+        build.spirv = read_spirv_module(SpirvModulePath(*spirv_directory_, vert_path_, defines_), vert_spirv) &&
+            read_spirv_module(SpirvModulePath(*spirv_directory_, frag_path_, defines_), frag_spirv);
+    }
+    if (build.spirv) {
+        build.spirv_uniforms = find_uniform_locations(vert_code);
+        std::vector<std::pair<int32_t, std::string>> frag_uniforms = find_uniform_locations(frag_code);
+        build.spirv_uniforms.insert(build.spirv_uniforms.end(), frag_uniforms.begin(), frag_uniforms.end());
     }
-    int32_t location = glGetUniformLocation(program_id_, name.data());
-    location_cache_[name] = location;
-    return location;
+    // SPIR-V programs are cached under the hash of the modules, so they never stand in for a
+    // GLSL build of the same sources (whose uniforms are found by name)
+    build.cache_key = build.spirv ? program_cache.MakeKey(vert_spirv, frag_spirv) : program_cache.MakeKey(vert_code, frag_code);
+    build.program = glCreateProgram();
+    if (program_cache.Load(build.cache_key, build.program)) {
+        build.from_cache = true;
+        return build;
+    }
+    // a rejected binary can leave the program in an odd state, so start over from a fresh one
+    glDeleteProgram(build.program);
+
+    // nothing below asks for a compile or link status, so with parallel compile the driver
+    // keeps working on its own threads until IsBuildComplete() finds the program done
+    auto submit_start = std::chrono::steady_clock::now();
+    if (build.spirv) {
+        build.vertex = LoadSpirvShader(vert_spirv, GL_VERTEX_SHADER);
+        build.fragment = LoadSpirvShader(frag_spirv, GL_FRAGMENT_SHADER);
+    } else {
+        build.vertex = CompileShader(vert_code, GL_VERTEX_SHADER);
+        build.fragment = CompileShader(frag_code, GL_FRAGMENT_SHADER);
+    }
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertex);
+    glAttachShader(build.program, build.fragment);
+    if (program_cache.IsEnabled()) {
+        glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(build.program);
+    build.compile_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+    return build;
+}
+
+bool Shader::IsBuildComplete(const ProgramBuild& build) const
+{
+    // without the extension any status query blocks and there is no way to ask whether the driver
+    // is done, so the first poll finishes the build there and then, stalling that frame (GL work
+    // can't move to another thread without a second, shared context)
+    if (build.from_cache || !gl_capabilities.parallel_shader_compile) {
+        return true;
+    }
+    int32_t complete = GL_FALSE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool Shader::FinishBuild(ProgramBuild& build) const
+{
+    // a module's source string numbers don't refer to the GLSL files
+    static const std::vector<std::filesystem::path> no_files;
+    if (build.from_cache) {
+        return true;
+    }
+    auto finish_start = std::chrono::steady_clock::now();
+    int32_t success = 0;
+    char info_log[512];
+    bool compiled = CheckShader(build.vertex, build.spirv ? no_files : build.vert_files) &&
+        CheckShader(build.fragment, build.spirv ? no_files : build.frag_files);
+    if (compiled) {
+        glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(build.program, 512, nullptr, info_log);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << info_log << std::endl;
+        }
+    }
+    if (!compiled || !success) {
+        DiscardBuild(build);
+        return false;
+    }
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+    build.vertex = 0;
+    build.fragment = 0;
+    // only the time this thread spent submitting and collecting, not the latency the async path hides
+    build.compile_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - finish_start).count();
+    program_cache.RecordCompile(build.compile_ms);
+    program_cache.Store(build.cache_key, build.program);
+    return true;
+}
+
+void Shader::DiscardBuild(ProgramBuild& build) const
+{
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+    glDeleteProgram(build.program);
+    build = ProgramBuild{};
+}
+
+void Shader::Poll(bool wait)
+{
+    if (!pending_ || (!wait && !IsBuildComplete(*pending_))) {
+        return;
+    }
+    ProgramBuild build = *pending_;
+    pending_.reset();
+    bool spirv = build.spirv;
+    if (!FinishBuild(build)) {
+        if (spirv) {
+            std::cout << "SPIR-V modules for " << vert_path_ << " + " << frag_path_ << " were rejected, compiling GLSL" << std::endl;
+            spirv_directory_.reset();
+            pending_ = StartBuild();
+            Poll(wait);
+            return;
+        }
+        if (status_ == ShaderStatus::READY) {
+            std::cout << "Keeping the previous program for " << vert_path_ << " + " << frag_path_ << std::endl;
+        } else {
+            status_ = ShaderStatus::FAILED;
+        }
+        return;
+    }
+    // the swap happens inside IsReady(), which callers only poll between frames
+    if (program_id_) {
+        gl_state.OnProgramDeleted(program_id_);
+        glDeleteProgram(program_id_);
+    }
+    program_id_ = build.program;
+    spirv_uniforms_ = std::move(build.spirv_uniforms);
+    build_stats_ = BuildStats{build.compile_ms, build.from_cache, build.spirv, 0};
+    if (gl_capabilities.program_binary) {
+        glGetProgramiv(program_id_, GL_PROGRAM_BINARY_LENGTH, &build_stats_.binary_size);
+    }
+    ReflectUniforms();
+    // block bindings are program state, so a relinked program needs it again
+    BindUniformBlock(FRAME_CONSTANTS_BLOCK, FRAME_CONSTANTS_BINDING);
+    status_ = ShaderStatus::READY;
+    ++generation_;
+}
+
+// builds the sorted uniform table for a freshly linked program and re-resolves existing handles
+void Shader::ReflectUniforms()
+{
+    uniforms_.clear();
+    int32_t count = 0;
+    int32_t max_length = 0;
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<char> name_buffer(static_cast<size_t>(std::max(max_length, 1)));
+    for (int32_t i = 0; i < count; ++i) {
+        int32_t length = 0;
+        int32_t size = 0;
+        uint32_t type = 0;
+        glGetActiveUniform(program_id_, static_cast<uint32_t>(i), max_length, &length, &size, &type, name_buffer.data());
+        std::string_view name{name_buffer.data(), static_cast<size_t>(length)};
+        int32_t location = -1;
+        if (build_stats_.spirv) {
+            // no names in SPIR-V: take the location from GL and the name from the GLSL declaration
+            const uint32_t property = GL_LOCATION;
+            glGetProgramResourceiv(program_id_, GL_UNIFORM, static_cast<uint32_t>(i), 1, &property, 1, nullptr, &location);
+            auto declared = std::find_if(spirv_uniforms_.begin(), spirv_uniforms_.end(),
+                [location](const std::pair<int32_t, std::string>& uniform) { return uniform.first == location; });
+            name = declared != spirv_uniforms_.end() ? std::string_view{declared->second} : std::string_view{};
+        } else {
+            location = glGetUniformLocation(program_id_, name_buffer.data());
+        }
+        // members of uniform blocks have no location and are set through their buffer
+        if (location < 0 || name.empty()) {
+            continue;
+        }
+        // arrays are reported as "name[0]"; callers address them by the bare name
+        if (name.size() > 3 && name.substr(name.size() - 3) == "[0]") {
+            name.remove_suffix(3);
+        }
+        uniforms_.push_back(UniformInfo{Fnv1a64(name), location, type, size, 0, uniform_size(type) * static_cast<uint32_t>(size), false, 0, 0});
+    }
+    std::sort(uniforms_.begin(), uniforms_.end(), [](const UniformInfo& a, const UniformInfo& b) { return a.hash < b.hash; });
+    uint32_t shadow_size = 0;
+    for (UniformInfo& uniform : uniforms_) {
+        uniform.offset = shadow_size;
+        shadow_size += uniform.size;
+    }
+    shadow_.assign(shadow_size, 0);
+    dirty_.clear();
+    auto duplicate = std::adjacent_find(uniforms_.begin(), uniforms_.end(),
+        [](const UniformInfo& a, const UniformInfo& b) { return a.hash == b.hash; });
+    if (duplicate != uniforms_.end()) {
+        std::cout << "WARNING::SHADER::UNIFORM_HASH_COLLISION in " << vert_path_ << " + " << frag_path_ << std::endl;
+    }
+
+    for (size_t i = 0; i < handle_hashes_.size(); ++i) {
+        handle_uniforms_[i] = FindUniform(handle_hashes_[i]);
+    }
+}
+
+uint32_t Shader::FindUniform(uint64_t hash) const
+{
+    auto it = std::lower_bound(uniforms_.begin(), uniforms_.end(), hash,
+        [](const UniformInfo& info, uint64_t value) { return info.hash < value; });
+    return it != uniforms_.end() && it->hash == hash ? static_cast<uint32_t>(it - uniforms_.begin()) : INVALID_UNIFORM;
+}
+
+uint32_t Shader::GetUniformIndex(std::string_view name) const
+{
+    return FindUniform(Fnv1a64(name));
+}
+
+// writes the leading `count` elements of an array uniform (1 for a plain one); elements past the
+// declared array size are dropped, like GL does
+void Shader::SetValue(uint32_t uniform, const void* data, size_t element_size, size_t count)
+{
+    // a uniform the program doesn't use is ignored, like glUniform* with location -1
+    if (uniform == INVALID_UNIFORM || count == 0) {
+        return;
+    }
+    ++uniform_stats.sets;
+    UniformInfo& info = uniforms_[uniform];
+    count = std::min(count, static_cast<size_t>(info.count));
+    uint8_t* shadow = shadow_.data() + info.offset;
+    size_t size = std::min(element_size * count, static_cast<size_t>(info.size));
+    if (static_cast<int32_t>(count) <= info.known_count && std::memcmp(shadow, data, size) == 0) {
+        return;
+    }
+    std::memcpy(shadow, data, size);
+    info.known_count = std::max(info.known_count, static_cast<int32_t>(count));
+    // one glUniform*v covers everything written since the last flush
+    info.upload_count = std::max(info.upload_count, static_cast<int32_t>(count));
+    if (!info.dirty) {
+        info.dirty = true;
+        dirty_.push_back(uniform);
+    }
+}
+
+const Shader::UniformStats& Shader::GetUniformStats()
+{
+    return uniform_stats;
+}
+
+void Shader::ResetUniformStats()
+{
+    uniform_stats = UniformStats{};
 }
\ No newline at end of file
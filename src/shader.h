@@ -1,32 +1,224 @@
 #pragma once
 
+#include "hash.h"
+
 #include <stdint.h>
 #include <string>
 #include <filesystem>
+#include <optional>
+#include <span>
 #include <string_view>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <glm/glm.hpp>
 
+enum class ShaderCompile
+{
+    // compile and link in the constructor, throwing on errors
+    BLOCKING,
+    // only submit the work; poll IsReady(). Never blocks with KHR_parallel_shader_compile; without
+    // it the first IsReady() after a submit waits for the compile and link to finish
+    ASYNC
+};
+
+// A uniform name hashed at compile time: static constexpr UniformName MODEL{"model"};
+struct UniformName
+{
+    constexpr UniformName(std::string_view name)
+        : hash(Fnv1a64(name))
+    {
+    }
+
+    uint64_t hash;
+};
+
+// Index into a Shader's handle table. Handles stay valid across hot reloads; a uniform the
+// current program doesn't use resolves to location -1, which GL ignores.
+struct UniformHandle
+{
+    uint32_t index;
+};
+
+// A preprocessor symbol injected right after the #version line; an empty value defines it as 1.
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
+using ShaderDefines = std::vector<ShaderDefine>;
+
+// Directory holding the SPIR-V modules compiled at build time, one per stage and define set
+// (see SpirvModulePath).
+struct SpirvModules
+{
+    std::filesystem::path directory;
+};
+
+// <directory>/<source file name>[+NAME[=VALUE]...].spv with the defines sorted by name, the
+// naming the CMake SPIR-V step uses
+std::filesystem::path SpirvModulePath(const std::filesystem::path& directory, const std::filesystem::path& source,
+    const ShaderDefines& defines);
+
+enum class ShaderStatus
+{
+    COMPILING,
+    READY,
+    FAILED
+};
+
 class Shader
 {
 public:
-    Shader(const std::filesystem::path& vert_path, const std::filesystem::path& frag_path);
+    // the defines are sorted by name, so the same set always produces the same sources
+    Shader(const std::filesystem::path& vert_path, const std::filesystem::path& frag_path,
+        const ShaderDefines& defines = {}, ShaderCompile compile = ShaderCompile::BLOCKING);
+    // loads the SPIR-V modules through GL_ARB_gl_spirv instead of compiling GLSL; the GLSL sources
+    // are still used when the driver lacks the extension, a module is missing or fails to
+    // specialize, and after a hot reload (the modules predate the edit)
+    Shader(const SpirvModules& spirv, const std::filesystem::path& vert_path, const std::filesystem::path& frag_path,
+        const ShaderDefines& defines = {}, ShaderCompile compile = ShaderCompile::BLOCKING);
     ~Shader();
 
+    struct BuildStats
+    {
+        // main-thread compile and link time of the last build, 0 when it came from the binary cache
+        double compile_ms = 0.0;
+        bool from_cache = false;
+        // built from the SPIR-V modules rather than GLSL
+        bool spirv = false;
+        // driver-side size of the linked program binary, 0 when the driver can't report it
+        int32_t binary_size = 0;
+    };
+
+    // counted over all shaders since the last ResetUniformStats()
+    struct UniformStats
+    {
+        uint64_t sets;
+        // glUniform* calls issued by Flush(); sets - uploads never reached the driver
+        uint64_t uploads;
+    };
+
 public:
+    // polls the pending build and swaps it in once it linked; call at a frame boundary.
+    // true while a usable program is installed
+    bool IsReady();
+    ShaderStatus GetStatus() const;
+    // rebuilds from the source files in the background; the current program stays in use until
+    // the new one has linked, and is kept if it fails. Only truly in the background with
+    // KHR_parallel_shader_compile: otherwise the next IsReady() compiles and links on the
+    // calling thread and stalls that frame for the duration
+    void Reload();
+    // both stages plus everything they include, as of the last build attempt
+    std::vector<std::filesystem::path> GetSourcePaths() const;
+    const ShaderDefines& GetDefines() const;
+    const BuildStats& GetBuildStats() const;
+    // bumped whenever a new program is swapped in; its uniforms and block bindings start from scratch
+    uint32_t GetGeneration() const;
     void Use();
-    void setBool(std::string_view name, bool value) const;
-    void setInteger(std::string_view name, int32_t value) const;
-    void setFloat(std::string_view name, float value) const;
-    void setMatrix4(std::string_view name, const glm::mat4& value) const;
+    // resolve once at setup; the set* overloads taking a handle are a single array lookup
+    UniformHandle GetUniform(UniformName name);
+    // the set* calls only write a CPU-side shadow of the program's uniforms and never touch GL,
+    // so the program doesn't have to be bound; a value equal to the shadow is dropped
+    void setBool(UniformHandle uniform, bool value);
+    void setInteger(UniformHandle uniform, int32_t value);
+    void setFloat(UniformHandle uniform, float value);
+    void setMatrix4(UniformHandle uniform, const glm::mat4& value);
+    // by-name variants hash the name and binary search the reflected table; fine outside hot loops
+    void setBool(std::string_view name, bool value);
+    void setInteger(std::string_view name, int32_t value);
+    void setFloat(std::string_view name, float value);
+    void setMatrix4(std::string_view name, const glm::mat4& value);
+    // fill the leading values.size() elements of a GLSL array uniform, uploaded with a single
+    // glUniform*v at the next flush; values beyond the declared array size are dropped
+    void setFloatArray(UniformHandle uniform, std::span<const float> values);
+    void setIntegerArray(UniformHandle uniform, std::span<const int32_t> values);
+    void setVec4Array(UniformHandle uniform, std::span<const glm::vec4> values);
+    void setMatrix4Array(UniformHandle uniform, std::span<const glm::mat4> values);
+    void setFloatArray(std::string_view name, std::span<const float> values);
+    void setIntegerArray(std::string_view name, std::span<const int32_t> values);
+    void setVec4Array(std::string_view name, std::span<const glm::vec4> values);
+    void setMatrix4Array(std::string_view name, std::span<const glm::mat4> values);
+    // uploads the uniforms changed since the last flush; call right before drawing, with this
+    // program bound
+    void Flush();
+    void BindUniformBlock(std::string_view name, uint32_t binding) const;
+
+    static const UniformStats& GetUniformStats();
+    static void ResetUniformStats();
 
 private:
-    std::string ReadShaderFile(const std::filesystem::path& file_path) const;
+    struct ProgramBuild
+    {
+        uint32_t program = 0;
+        uint32_t vertex = 0;
+        uint32_t fragment = 0;
+        uint64_t cache_key = 0;
+        bool from_cache = false;
+        bool spirv = false;
+        double compile_ms = 0.0;
+        // SPIR-V drops uniform names; the GLSL declares explicit locations instead (location, name)
+        std::vector<std::pair<int32_t, std::string>> spirv_uniforms;
+        // per stage, the file behind each source string number for mapping compiler messages
+        std::vector<std::filesystem::path> vert_files;
+        std::vector<std::filesystem::path> frag_files;
+    };
+
+private:
+    void Start(ShaderCompile compile);
+    std::string InjectDefines(const std::string& code) const;
     uint32_t CompileShader(std::string_view shader_code, uint32_t shader_type) const;
-    int32_t GetUniformLocation(std::string_view name) const;
+    uint32_t LoadSpirvShader(std::string_view spirv, uint32_t shader_type) const;
+    bool CheckShader(uint32_t shader_id, const std::vector<std::filesystem::path>& files) const;
+    ProgramBuild StartBuild();
+    bool IsBuildComplete(const ProgramBuild& build) const;
+    bool FinishBuild(ProgramBuild& build) const;
+    void DiscardBuild(ProgramBuild& build) const;
+    void Poll(bool wait);
+    void ReflectUniforms();
+    uint32_t FindUniform(uint64_t hash) const;
+    uint32_t GetUniformIndex(std::string_view name) const;
+    void SetValue(uint32_t uniform, const void* data, size_t element_size, size_t count);
 
 private:
+    std::filesystem::path vert_path_;
+    std::filesystem::path frag_path_;
+    ShaderDefines defines_;
+    std::optional<std::filesystem::path> spirv_directory_;
+    // names of the current program's uniforms by location, when it was built from SPIR-V
+    std::vector<std::pair<int32_t, std::string>> spirv_uniforms_;
+    std::vector<std::filesystem::path> source_files_;
+    BuildStats build_stats_;
     uint32_t program_id_;
-    mutable std::unordered_map<std::string_view, int32_t> location_cache_;
+    ShaderStatus status_;
+    uint32_t generation_;
+    std::optional<ProgramBuild> pending_;
+
+    struct UniformInfo
+    {
+        uint64_t hash;
+        int32_t location;
+        uint32_t type;
+        int32_t count;
+        // byte range of the value in shadow_
+        uint32_t offset;
+        uint32_t size;
+        bool dirty;
+        // elements to upload at the next flush
+        int32_t upload_count;
+        // leading elements whose shadow matches the program; the initial values after a link
+        // (binding layouts, initializers) aren't read back, so a set is only dropped past a first upload
+        int32_t known_count;
+    };
+    // active uniforms of the current program, sorted by name hash
+    std::vector<UniformInfo> uniforms_;
+    // values last set for every entry of uniforms_, zeroed until then
+    std::vector<uint8_t> shadow_;
+    // indices into uniforms_ waiting for the next Flush()
+    std::vector<uint32_t> dirty_;
+    // per handle: the name hash it was created from and its index in uniforms_ (INVALID_UNIFORM
+    // when the current program doesn't use it)
+    std::vector<uint64_t> handle_hashes_;
+    std::vector<uint32_t> handle_uniforms_;
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "shader_preprocessor.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+ShaderPreprocessor shader_preprocessor{};
+
+// matches `#include "name"` with optional whitespace around the '#'; returns false for any other line
+static bool parse_include(std::string_view line, std::string_view& name)
+{
+    auto skip_spaces = [&line]() {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+            line.remove_prefix(1);
+        }
+    };
+    skip_spaces();
+    if (line.empty() || line.front() != '#') {
+        return false;
+    }
+    line.remove_prefix(1);
+    skip_spaces();
+    constexpr std::string_view DIRECTIVE{"include"};
+    if (line.substr(0, DIRECTIVE.size()) != DIRECTIVE) {
+        return false;
+    }
+    line.remove_prefix(DIRECTIVE.size());
+    skip_spaces();
+    if (line.empty() || line.front() != '"') {
+        return false;
+    }
+    size_t end = line.find('"', 1);
+    if (end == std::string_view::npos) {
+        return false;
+    }
+    name = line.substr(1, end - 1);
+    return true;
+}
+
+ExpandedSource ShaderPreprocessor::Expand(const std::filesystem::path& path)
+{
+    std::filesystem::path root = path.lexically_normal();
+    auto it = entries_.find(root.string());
+    if (it != entries_.end() && IsCurrent(it->second)) {
+        ++hits_;
+        return it->second.source;
+    }
+    ++misses_;
+    Entry entry{};
+    std::vector<uint32_t> stack;
+    ExpandFile(root, entry, stack);
+    return (entries_[root.string()] = std::move(entry)).source;
+}
+
+void ShaderPreprocessor::PrintStats() const
+{
+    std::cout << "Shader preprocessor: " << misses_ << " expansions, " << hits_ << " reused from the cache" << std::endl;
+}
+
+std::string ShaderPreprocessor::ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        std::cout << "ERROR::SHADER::FAILED_TO_READ_FILE: " << path << std::endl;
+        throw std::runtime_error(path.string());
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+bool ShaderPreprocessor::IsCurrent(const Entry& entry)
+{
+    for (size_t i = 0; i < entry.source.files.size(); ++i) {
+        std::ifstream file{entry.source.files[i], std::ios::binary};
+        if (!file) {
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        if (Fnv1a64(stream.str()) != entry.hashes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShaderPreprocessor::ExpandFile(const std::filesystem::path& path, Entry& entry, std::vector<uint32_t>& stack) const
+{
+    ExpandedSource& source = entry.source;
+    uint32_t index = static_cast<uint32_t>(source.files.size());
+    std::string text = ReadFile(path);
+    source.files.push_back(path);
+    entry.hashes.push_back(Fnv1a64(text));
+    stack.push_back(index);
+
+    size_t line_number = 0;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        end = end == std::string::npos ? text.size() : end;
+        std::string_view line{text.data() + begin, end - begin};
+        begin = end + 1;
+        ++line_number;
+
+        std::string_view name;
+        if (!parse_include(line, name)) {
+            source.code.append(line);
+            source.code += '\n';
+            continue;
+        }
+        std::filesystem::path include = (path.parent_path() / std::filesystem::path{name}).lexically_normal();
+        auto known = std::find(source.files.begin(), source.files.end(), include);
+        if (known == source.files.end()) {
+            uint32_t child = static_cast<uint32_t>(source.files.size());
+            source.includes.emplace_back(index, child);
+            source.code += "#line 1 " + std::to_string(child) + '\n';
+            ExpandFile(include, entry, stack);
+            source.code += "#line " + std::to_string(line_number + 1) + ' ' + std::to_string(index) + '\n';
+            continue;
+        }
+        uint32_t included = static_cast<uint32_t>(known - source.files.begin());
+        if (std::find(stack.begin(), stack.end(), included) != stack.end()) {
+            std::string chain;
+            for (uint32_t file : stack) {
+                chain += source.files[file].string() + " -> ";
+            }
+            throw std::runtime_error("#include cycle: " + chain + include.string());
+        }
+        // already pasted through another branch of the graph; keep the line so numbering holds
+        source.includes.emplace_back(index, included);
+        source.code += '\n';
+    }
+    stack.pop_back();
+}
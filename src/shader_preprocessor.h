@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A shader source with every #include "..." resolved.
+struct ExpandedSource
+{
+    std::string code;
+    // files[0] is the root; a file's index is the source string number used in its #line
+    // directives, so the "N:" prefix of a compiler message names the file
+    std::vector<std::filesystem::path> files;
+    // the include graph as (includer, included) indices into files
+    std::vector<std::pair<uint32_t, uint32_t>> includes;
+};
+
+// Resolves #include "path" directives relative to the including file. Each file is pasted at
+// most once per expansion, so shared headers need no guards; a file that includes one of its
+// own includers is an error. Includes are resolved before the GLSL preprocessor runs, so an
+// #include inside #ifdef is pasted either way. Expansions are cached per root and reused while the content hash
+// of every file in the graph is unchanged, so shader permutations sharing sources expand once.
+class ShaderPreprocessor
+{
+public:
+    // throws std::runtime_error for unreadable files and include cycles
+    ExpandedSource Expand(const std::filesystem::path& path);
+    void PrintStats() const;
+
+private:
+    struct Entry
+    {
+        ExpandedSource source;
+        // content hash of each file in source.files at the time of the expansion
+        std::vector<uint64_t> hashes;
+    };
+
+private:
+    static std::string ReadFile(const std::filesystem::path& path);
+    static bool IsCurrent(const Entry& entry);
+    void ExpandFile(const std::filesystem::path& path, Entry& entry, std::vector<uint32_t>& stack) const;
+
+private:
+    std::unordered_map<std::string, Entry> entries_;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+};
+
+extern ShaderPreprocessor shader_preprocessor;
@@ -0,0 +1,112 @@
+#include "shader_variants.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+void ShaderVariantCache::SetSpirvDirectory(const std::filesystem::path& directory)
+{
+    spirv_directory_ = directory;
+}
+
+Shader& ShaderVariantCache::Get(const ShaderVariant& variant)
+{
+    uint64_t key = MakeKey(variant);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        auto shader = spirv_directory_ ?
+            std::make_unique<Shader>(SpirvModules{*spirv_directory_}, variant.vert_path, variant.frag_path, variant.defines,
+                ShaderCompile::ASYNC) :
+            std::make_unique<Shader>(variant.vert_path, variant.frag_path, variant.defines, ShaderCompile::ASYNC);
+        it = entries_.emplace(key, Entry{variant, std::move(shader)}).first;
+        order_.push_back(key);
+    }
+    return *it->second.shader;
+}
+
+void ShaderVariantCache::Precompile(const std::vector<ShaderVariant>& variants)
+{
+    for (const ShaderVariant& variant : variants) {
+        Get(variant);
+    }
+}
+
+bool ShaderVariantCache::IsReady()
+{
+    bool ready = true;
+    for (uint64_t key : order_) {
+        Shader& shader = *entries_.at(key).shader;
+        ready = shader.IsReady() && ready;
+        if (shader.GetStatus() == ShaderStatus::FAILED) {
+            throw std::runtime_error("shader build failed: " + entries_.at(key).variant.vert_path.string());
+        }
+    }
+    return ready;
+}
+
+std::vector<Shader*> ShaderVariantCache::GetShaders() const
+{
+    std::vector<Shader*> shaders;
+    shaders.reserve(order_.size());
+    for (uint64_t key : order_) {
+        shaders.push_back(entries_.at(key).shader.get());
+    }
+    return shaders;
+}
+
+void ShaderVariantCache::PrintStats() const
+{
+    double total_ms = 0.0;
+    int64_t total_bytes = 0;
+    std::cout << "Shader variants: " << order_.size() << std::endl;
+    for (uint64_t key : order_) {
+        const Entry& entry = entries_.at(key);
+        const Shader::BuildStats& stats = entry.shader->GetBuildStats();
+        std::cout << "  " << entry.variant.vert_path.filename().string() << " + " << entry.variant.frag_path.filename().string();
+        for (const ShaderDefine& define : entry.shader->GetDefines()) {
+            std::cout << " " << define.name;
+            if (!define.value.empty()) {
+                std::cout << "=" << define.value;
+            }
+        }
+        std::cout << (stats.spirv ? ": SPIR-V, " : ": GLSL, ");
+        if (stats.from_cache) {
+            std::cout << "cached, ";
+        } else {
+            std::cout << stats.compile_ms << " ms, ";
+        }
+        if (stats.binary_size > 0) {
+            std::cout << stats.binary_size / 1024.0 << " KiB" << std::endl;
+        } else {
+            std::cout << "size unknown" << std::endl;
+        }
+        total_ms += stats.compile_ms;
+        total_bytes += stats.binary_size;
+    }
+    std::cout << "  total: " << total_ms << " ms compiling, " << total_bytes / 1024.0 << " KiB of program binaries" << std::endl;
+}
+
+void ShaderVariantCache::Clear()
+{
+    entries_.clear();
+    order_.clear();
+}
+
+// the sources are identified by path rather than content, so a hot reload updates the existing
+// entry in place instead of turning into a new permutation
+uint64_t ShaderVariantCache::MakeKey(const ShaderVariant& variant)
+{
+    ShaderDefines defines = variant.defines;
+    std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+    uint64_t key = Fnv1a64(variant.vert_path.generic_string());
+    key = Fnv1a64(std::string_view{"\0", 1}, key);
+    key = Fnv1a64(variant.frag_path.generic_string(), key);
+    for (const ShaderDefine& define : defines) {
+        key = Fnv1a64(std::string_view{"\0", 1}, key);
+        key = Fnv1a64(define.name, key);
+        key = Fnv1a64("=", key);
+        key = Fnv1a64(define.value, key);
+    }
+    return key;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "shader.h"
+
+#include <stdint.h>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// One permutation of a vertex/fragment pair.
+struct ShaderVariant
+{
+    std::filesystem::path vert_path;
+    std::filesystem::path frag_path;
+    ShaderDefines defines;
+};
+
+// Owns every program permutation the renderer asked for, keyed by (sources, define set) so
+// requesting the same combination twice returns the same Shader. Define order doesn't matter.
+// Programs are built asynchronously; the binary cache underneath keys on the expanded sources,
+// so each permutation is also cached on disk separately.
+class ShaderVariantCache
+{
+public:
+    // permutations requested afterwards load the build-time SPIR-V modules from this directory
+    void SetSpirvDirectory(const std::filesystem::path& directory);
+    Shader& Get(const ShaderVariant& variant);
+    // submits every listed permutation at once so the driver can compile them side by side;
+    // poll IsReady() before drawing with any of them
+    void Precompile(const std::vector<ShaderVariant>& variants);
+    // polls all pending builds; throws when a first build failed
+    bool IsReady();
+    std::vector<Shader*> GetShaders() const;
+    // compile time and binary size per permutation
+    void PrintStats() const;
+    void Clear();
+
+private:
+    static uint64_t MakeKey(const ShaderVariant& variant);
+
+private:
+    struct Entry
+    {
+        ShaderVariant variant;
+        std::unique_ptr<Shader> shader;
+    };
+    std::optional<std::filesystem::path> spirv_directory_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    // insertion order, so stats and iteration are stable
+    std::vector<uint64_t> order_;
+};
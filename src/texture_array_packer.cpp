@@ -0,0 +1,189 @@
+#include "texture_array_packer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+TextureArrayPacker::TextureArrayPacker()
+    : copy_buffer_(0), packed_(0), buffer_copies_(0), image_copies_(0), bytes_(0), pack_ms_(0.0)
+{
+}
+
+TextureArrayPacker::~TextureArrayPacker()
+{
+    for (uint32_t array : arrays_) {
+        gl_state.OnTextureDeleted(array);
+    }
+    glDeleteTextures(static_cast<int32_t>(arrays_.size()), arrays_.data());
+    glDeleteBuffers(1, &copy_buffer_);
+}
+
+std::vector<TextureLayer> TextureArrayPacker::Pack(const std::vector<uint32_t>& textures, const TextureParams& params)
+{
+    TRACE_SCOPE("TextureArrayPacker::Pack");
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Source> sources;
+    std::vector<Group> groups;
+    // index into sources for every requested texture, so a texture listed twice is copied once
+    std::vector<size_t> source_of;
+    for (uint32_t texture : textures) {
+        auto known = std::find_if(sources.begin(), sources.end(), [texture](const Source& source) { return source.texture == texture; });
+        if (known != sources.end()) {
+            source_of.push_back(static_cast<size_t>(known - sources.begin()));
+            continue;
+        }
+        Source source = Describe(texture);
+        auto group = std::find_if(groups.begin(), groups.end(), [&source](const Group& group) {
+            return group.width == source.width && group.height == source.height && group.levels == source.levels;
+        });
+        if (group == groups.end()) {
+            groups.push_back(Group{source.width, source.height, source.levels, source.internal_format, source.compressed, {}});
+            group = groups.end() - 1;
+        }
+        // one member in another format and the whole group falls back to plain texels
+        if (group->internal_format != source.internal_format || !source.compressed) {
+            group->internal_format = GL_RGBA8;
+            group->compressed = false;
+        }
+        group->members.push_back(sources.size());
+        source_of.push_back(sources.size());
+        sources.push_back(source);
+    }
+
+    std::vector<TextureLayer> source_layers(sources.size());
+    for (const Group& group : groups) {
+        uint32_t array = CreateArray(group, sources, params);
+        for (uint32_t layer = 0; layer < group.members.size(); ++layer) {
+            size_t member = group.members[layer];
+            CopyLayer(group, sources[member], array, layer);
+            source_layers[member] = TextureLayer{array, layer};
+        }
+        arrays_.push_back(array);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    std::vector<TextureLayer> layers;
+    layers.reserve(textures.size());
+    for (size_t source : source_of) {
+        layers.push_back(source_layers[source]);
+    }
+    packed_ += static_cast<uint32_t>(sources.size());
+    pack_ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return layers;
+}
+
+const std::vector<uint32_t>& TextureArrayPacker::GetArrays() const
+{
+    return arrays_;
+}
+
+void TextureArrayPacker::PrintStats() const
+{
+    std::cout << "Texture arrays: " << packed_ << " textures packed into " << arrays_.size() << " arrays, "
+              << static_cast<double>(bytes_) / (1024.0 * 1024.0) << " MiB in " << pack_ms_ << " ms (" << image_copies_
+              << " glCopyImageSubData, " << buffer_copies_ << " buffer copies)" << std::endl;
+}
+
+TextureArrayPacker::Source TextureArrayPacker::Describe(uint32_t texture)
+{
+    Source source{texture, 0, 0, 0, 0, false};
+    gl_state.BindTexture(0, GL_TEXTURE_2D, texture);
+    int32_t value = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &source.width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &source.height);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &value);
+    source.internal_format = static_cast<uint32_t>(value);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &value);
+    source.compressed = value != 0;
+
+    // the levels that are actually specified, up to the 1x1 one or GL_TEXTURE_MAX_LEVEL
+    int32_t max_level = 0;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+    int32_t width = source.width;
+    int32_t height = source.height;
+    for (source.levels = 1; source.levels <= max_level && (width > 1 || height > 1); ++source.levels) {
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, source.levels, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, source.levels, GL_TEXTURE_HEIGHT, &height);
+        if (width == 0) {
+            break;
+        }
+    }
+    return source;
+}
+
+uint32_t TextureArrayPacker::CreateArray(const Group& group, const std::vector<Source>& sources, const TextureParams& params)
+{
+    uint32_t array = 0;
+    glGenTextures(1, &array);
+    gl_state.BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, static_cast<int32_t>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, static_cast<int32_t>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, static_cast<int32_t>(params.min_filter));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, static_cast<int32_t>(params.mag_filter));
+    // keeps the array complete for mipmapped filters when the sources stop short of 1x1
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, group.levels - 1);
+
+    int32_t layers = static_cast<int32_t>(group.members.size());
+    for (int32_t level = 0; level < group.levels; ++level) {
+        int32_t width = std::max(1, group.width >> level);
+        int32_t height = std::max(1, group.height >> level);
+        if (group.compressed) {
+            int32_t layer_size = 0;
+            gl_state.BindTexture(0, GL_TEXTURE_2D, sources[group.members[0]].texture);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &layer_size);
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, group.internal_format, width, height, layers, 0, layer_size * layers, nullptr);
+            bytes_ += static_cast<size_t>(layer_size) * static_cast<size_t>(layers);
+        } else {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            bytes_ += static_cast<size_t>(width) * static_cast<size_t>(height) * 4 * static_cast<size_t>(layers);
+        }
+    }
+    return array;
+}
+
+void TextureArrayPacker::CopyLayer(const Group& group, const Source& source, uint32_t array, uint32_t layer)
+{
+    int32_t z = static_cast<int32_t>(layer);
+    if (gl_capabilities.copy_image && source.internal_format == group.internal_format) {
+        for (int32_t level = 0; level < group.levels; ++level) {
+            glCopyImageSubData(source.texture, GL_TEXTURE_2D, level, 0, 0, 0, array, GL_TEXTURE_2D_ARRAY, level, 0, 0, z,
+                std::max(1, group.width >> level), std::max(1, group.height >> level), 1);
+        }
+        image_copies_ += static_cast<uint32_t>(group.levels);
+        return;
+    }
+
+    // read each level into a buffer and specify the layer from it; orphaning the buffer for every
+    // level lets the driver pipeline the copies instead of waiting for the previous one
+    if (!copy_buffer_) {
+        glGenBuffers(1, &copy_buffer_);
+    }
+    gl_state.BindTexture(0, GL_TEXTURE_2D, source.texture);
+    gl_state.BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+    for (int32_t level = 0; level < group.levels; ++level) {
+        int32_t width = std::max(1, group.width >> level);
+        int32_t height = std::max(1, group.height >> level);
+        int32_t size = width * height * 4;
+        if (group.compressed) {
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, copy_buffer_);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_COPY);
+        if (group.compressed) {
+            glGetCompressedTexImage(GL_TEXTURE_2D, level, nullptr);
+        } else {
+            glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, copy_buffer_);
+        if (group.compressed) {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, z, width, height, 1, group.internal_format, size, nullptr);
+        } else {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, z, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+    buffer_copies_ += static_cast<uint32_t>(group.levels);
+}
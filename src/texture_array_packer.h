@@ -0,0 +1,77 @@
+#pragma once
+
+#include "texture_loader.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Uniform buffer binding point of the MaterialLayers block in assets/shaders/materials.glsl: one
+// ivec4 per material holding the layers of its textures.
+inline constexpr uint32_t MATERIAL_LAYERS_BINDING = 1;
+inline constexpr const char* MATERIAL_LAYERS_BLOCK = "MaterialLayers";
+inline constexpr uint32_t MAX_LAYERED_MATERIALS = 256;
+
+// Where a packed texture ended up.
+struct TextureLayer
+{
+    uint32_t array;
+    uint32_t layer;
+};
+
+// Copies resident 2D textures into the layers of GL_TEXTURE_2D_ARRAYs, so materials that only
+// differ in their images can share one binding and pick their images by layer in the shader.
+// Textures with the same size and level count share an array. A group keeps its block-compressed
+// format when all of its textures have the same one and is stored as RGBA8 otherwise (the GL
+// decompresses on the copy). The copies never leave the GPU: glCopyImageSubData where the formats
+// match and the context has it, a pixel pack/unpack buffer round trip otherwise.
+class TextureArrayPacker
+{
+public:
+    TextureArrayPacker();
+    ~TextureArrayPacker();
+    TextureArrayPacker(const TextureArrayPacker&) = delete;
+    TextureArrayPacker& operator=(const TextureArrayPacker&) = delete;
+
+public:
+    // the textures must be resident and stay owned by the caller; the result is in the order given.
+    // Every array samples with params, the sampling state of the source textures doesn't carry over
+    std::vector<TextureLayer> Pack(const std::vector<uint32_t>& textures, const TextureParams& params = {});
+    const std::vector<uint32_t>& GetArrays() const;
+    void PrintStats() const;
+
+private:
+    struct Source
+    {
+        uint32_t texture;
+        int32_t width;
+        int32_t height;
+        int32_t levels;
+        uint32_t internal_format;
+        bool compressed;
+    };
+
+    struct Group
+    {
+        int32_t width;
+        int32_t height;
+        int32_t levels;
+        // RGBA8 unless every member shares one compressed format
+        uint32_t internal_format;
+        bool compressed;
+        std::vector<size_t> members;
+    };
+
+private:
+    static Source Describe(uint32_t texture);
+    uint32_t CreateArray(const Group& group, const std::vector<Source>& sources, const TextureParams& params);
+    void CopyLayer(const Group& group, const Source& source, uint32_t array, uint32_t layer);
+
+private:
+    std::vector<uint32_t> arrays_;
+    uint32_t copy_buffer_;
+    uint32_t packed_;
+    uint32_t buffer_copies_;
+    uint32_t image_copies_;
+    size_t bytes_;
+    double pack_ms_;
+};
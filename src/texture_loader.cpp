@@ -0,0 +1,305 @@
+#include "texture_loader.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "trace.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static uint32_t pixel_format(int32_t channels)
+{
+    switch (channels) {
+    case 1:
+        return GL_RED;
+    case 2:
+        return GL_RG;
+    case 3:
+        return GL_RGB;
+    default:
+        return GL_RGBA;
+    }
+}
+
+static uint32_t internal_format(int32_t channels)
+{
+    switch (channels) {
+    case 1:
+        return GL_R8;
+    case 2:
+        return GL_RG8;
+    case 3:
+        return GL_RGB8;
+    default:
+        return GL_RGBA8;
+    }
+}
+
+// the GL format a baked container uploads as, 0 when the context can't sample it
+static uint32_t compressed_format(Ktx2Format format)
+{
+    switch (format) {
+    case Ktx2Format::BC1_RGB_UNORM:
+        return gl_capabilities.texture_compression_s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+    case Ktx2Format::BC1_RGB_SRGB:
+        return gl_capabilities.texture_compression_s3tc_srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : 0;
+    case Ktx2Format::BC3_UNORM:
+        return gl_capabilities.texture_compression_s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+    case Ktx2Format::BC3_SRGB:
+        return gl_capabilities.texture_compression_s3tc_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : 0;
+    case Ktx2Format::BC7_UNORM:
+        return gl_capabilities.texture_compression_bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+    case Ktx2Format::BC7_SRGB:
+        return gl_capabilities.texture_compression_bptc ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : 0;
+    default:
+        return 0;
+    }
+}
+
+TextureLoader::TextureLoader(uint32_t worker_count, size_t upload_budget)
+    : upload_budget_(upload_budget), stopping_(false), in_flight_(0), loaded_(0), failed_(0), compressed_(0), decode_ms_total_(0.0),
+      decode_ms_max_(0.0), bytes_uploaded_(0), upload_frames_(0), resident_ms_(0.0)
+{
+    if (worker_count == 0) {
+        // hardware_concurrency() may be 0 when it can't tell
+        worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back(&TextureLoader::WorkerLoop, this);
+    }
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    // unfinished uploads only own their staging buffers, the textures belong to the caller
+    for (Upload& upload : uploads_) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glDeleteBuffers(1, &upload.buffer);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureLoader::SetBakedDirectory(const std::filesystem::path& directory)
+{
+    baked_directory_ = directory;
+}
+
+uint32_t TextureLoader::Load(const std::filesystem::path& path, const TextureParams& params)
+{
+    TRACE_SCOPE("TextureLoader::Load");
+    uint32_t texture = 0;
+    glGenTextures(1, &texture);
+    gl_state.BindTexture(0, GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<int32_t>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<int32_t>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<int32_t>(params.min_filter));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<int32_t>(params.mag_filter));
+    // a single mid-grey texel is a complete texture for every filter, mipmapped or not
+    const uint8_t placeholder[4] = {128, 128, 128, 255};
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+    if (in_flight_ == 0) {
+        first_request_ = std::chrono::steady_clock::now();
+    }
+    ++in_flight_;
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::filesystem::path baked_path;
+        if (!baked_directory_.empty()) {
+            baked_path = baked_directory_ / path.filename();
+            baked_path += ".ktx2";
+        }
+        requests_.push_back(Request{path, params, texture, std::move(baked_path)});
+    }
+    wake_.notify_one();
+    return texture;
+}
+
+void TextureLoader::Update()
+{
+    if (in_flight_ == 0) {
+        return;
+    }
+    TRACE_SCOPE("TextureLoader::Update");
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        while (!decoded_.empty()) {
+            Decoded image = std::move(decoded_.front());
+            decoded_.pop_front();
+            if (image.pixels.empty()) {
+                std::cout << "Failed to load image " << image.request.path << ", keeping the placeholder" << std::endl;
+                ++failed_;
+                --in_flight_;
+                continue;
+            }
+            uploads_.push_back(Upload{std::move(image), 0, nullptr, 0});
+        }
+    }
+
+    // staging continues into later uploads while budget is left, but specifying (and mipmapping)
+    // is the expensive part on the GL side, so at most one texture becomes resident per frame
+    size_t budget = upload_budget_;
+    bool uploaded = false;
+    bool specified = false;
+    for (size_t i = 0; i < uploads_.size() && budget > 0; ++i) {
+        uploaded = true;
+        if (!Stage(uploads_[i], budget) || specified) {
+            continue;
+        }
+        Finish(uploads_[i]);
+        uploads_.erase(uploads_.begin() + static_cast<std::ptrdiff_t>(i));
+        --i;
+        specified = true;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    upload_frames_ += uploaded ? 1 : 0;
+    if (in_flight_ == 0) {
+        resident_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - first_request_).count();
+    }
+}
+
+bool TextureLoader::IsIdle() const
+{
+    return in_flight_ == 0;
+}
+
+void TextureLoader::PrintStats() const
+{
+    std::cout << "Texture loader: " << loaded_ << " loaded (" << compressed_ << " from baked KTX2), " << failed_ << " failed on " << workers_.size() << " workers, "
+              << decode_ms_total_ << " ms decoding in total (longest " << decode_ms_max_ << " ms), all resident after "
+              << resident_ms_ << " ms; " << static_cast<double>(bytes_uploaded_) / (1024.0 * 1024.0) << " MiB staged over "
+              << upload_frames_ << " frames" << std::endl;
+}
+
+void TextureLoader::WorkerLoop()
+{
+    Tracer::SetThreadName("texture decode");
+    for (;;) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            wake_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            request = std::move(requests_.front());
+            requests_.pop_front();
+        }
+
+        TRACE_SCOPE("decode");
+        auto start = std::chrono::steady_clock::now();
+        Decoded image{std::move(request), {}, 0, 0, 0, 0.0, 0, {}};
+        if (!LoadBaked(image)) {
+            // the flip flag is per thread, so workers don't race on stb_image's global one
+            stbi_set_flip_vertically_on_load_thread(image.request.params.flip_vertically);
+            uint8_t* pixels = stbi_load(image.request.path.string().c_str(), &image.width, &image.height, &image.channels, 0);
+            if (pixels) {
+                image.pixels.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * image.channels);
+                stbi_image_free(pixels);
+            }
+        }
+        image.decode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        decoded_.push_back(std::move(image));
+    }
+}
+
+bool TextureLoader::LoadBaked(Decoded& image)
+{
+    const std::filesystem::path& path = image.request.baked_path;
+    std::error_code error;
+    if (path.empty() || !std::filesystem::exists(path, error)) {
+        return false;
+    }
+    std::optional<Ktx2Texture> baked = ReadKtx2(path);
+    if (!baked) {
+        return false;
+    }
+    // blocks can't be flipped on upload, so texbake bakes the row order in
+    const char* orientation = image.request.params.flip_vertically ? "ru" : "rd";
+    if (baked->orientation != orientation) {
+        std::cout << path << " is stored " << baked->orientation << " instead of " << orientation << ", decoding "
+                  << image.request.path << " instead" << std::endl;
+        return false;
+    }
+    image.compressed_format = compressed_format(baked->format);
+    if (!image.compressed_format) {
+        std::cout << "No GL support for " << Ktx2FormatName(baked->format) << " in " << path << ", decoding "
+                  << image.request.path << " instead" << std::endl;
+        return false;
+    }
+    image.width = static_cast<int32_t>(baked->width);
+    image.height = static_cast<int32_t>(baked->height);
+    image.channels = 4;
+    image.pixels = std::move(baked->data);
+    image.levels = std::move(baked->levels);
+    return true;
+}
+
+bool TextureLoader::Stage(Upload& upload, size_t& budget)
+{
+    size_t size = upload.image.pixels.size();
+    if (!upload.buffer) {
+        glGenBuffers(1, &upload.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+        // stays mapped across frames; GL doesn't read the buffer until it is unmapped in Finish()
+        upload.mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    }
+    size_t chunk = std::min(budget, size - upload.staged);
+    std::memcpy(upload.mapped + upload.staged, upload.image.pixels.data() + upload.staged, chunk);
+    upload.staged += chunk;
+    budget -= chunk;
+    bytes_uploaded_ += chunk;
+    return upload.staged == size;
+}
+
+void TextureLoader::Finish(Upload& upload)
+{
+    TRACE_SCOPE("texture_specify");
+    const Decoded& image = upload.image;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    gl_state.BindTexture(0, GL_TEXTURE_2D, image.request.texture);
+    if (image.compressed_format) {
+        // the baked chain replaces glGenerateMipmap; without mipmaps only the top level is needed
+        size_t level_count = image.request.params.generate_mipmaps ? image.levels.size() : 1;
+        for (size_t level = 0; level < level_count; ++level) {
+            const Ktx2Level& source = image.levels[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int32_t>(level), image.compressed_format,
+                std::max(1, image.width >> level), std::max(1, image.height >> level), 0,
+                static_cast<GLsizei>(source.size), reinterpret_cast<const void*>(source.offset));
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int32_t>(level_count - 1));
+        ++compressed_;
+    } else {
+        // stb_image rows are tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<int32_t>(internal_format(image.channels)), image.width, image.height, 0,
+            pixel_format(image.channels), GL_UNSIGNED_BYTE, nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (image.request.params.generate_mipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+    }
+    // the driver keeps the storage alive until the copy out of it has run
+    glDeleteBuffers(1, &upload.buffer);
+
+    ++loaded_;
+    --in_flight_;
+    decode_ms_total_ += image.decode_ms;
+    decode_ms_max_ = std::max(decode_ms_max_, image.decode_ms);
+}
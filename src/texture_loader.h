@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ktx2.h"
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TextureParams
+{
+    uint32_t wrap = GL_REPEAT;
+    uint32_t min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    uint32_t mag_filter = GL_LINEAR;
+    bool generate_mipmaps = true;
+    bool flip_vertically = true;
+};
+
+// Decodes images on a pool of worker threads and streams them to GL through pixel unpack
+// buffers. Load() returns a texture name right away, holding a 1x1 placeholder texel; the real
+// image replaces it once it is resident, so materials can be set up with the final name.
+// Update() runs on the GL thread once per frame and copies at most the byte budget into the
+// staging buffers, so no single frame pays for a large texture set. A texture is specified
+// from its buffer only once all of it has been staged.
+// With a baked directory set, <directory>/<file name>.ktx2 written by texbake is preferred: its
+// block-compressed mip chain is staged the same way and uploaded level by level. The source
+// image is decoded instead when there is no container, or the GL can't sample its format.
+class TextureLoader
+{
+public:
+    // 0 picks one worker per hardware thread, leaving one for the render thread
+    explicit TextureLoader(uint32_t worker_count = 0, size_t upload_budget = 8u << 20);
+    ~TextureLoader();
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+public:
+    // applies to the Load() calls that follow
+    void SetBakedDirectory(const std::filesystem::path& directory);
+    // the caller owns the returned texture and deletes it; call Update() before doing so
+    uint32_t Load(const std::filesystem::path& path, const TextureParams& params = {});
+    // stages decoded images and finishes uploads; call once per frame with the context current
+    void Update();
+    // true once every requested texture is resident or has failed
+    bool IsIdle() const;
+    void PrintStats() const;
+
+private:
+    struct Request
+    {
+        std::filesystem::path path;
+        TextureParams params;
+        uint32_t texture;
+        // empty when no baked directory is set
+        std::filesystem::path baked_path;
+    };
+
+    struct Decoded
+    {
+        Request request;
+        // tightly packed texels, or the whole compressed mip chain when compressed_format is set
+        std::vector<uint8_t> pixels;
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        double decode_ms;
+        uint32_t compressed_format;
+        std::vector<Ktx2Level> levels;
+    };
+
+    struct Upload
+    {
+        Decoded image;
+        uint32_t buffer;
+        uint8_t* mapped;
+        size_t staged;
+    };
+
+private:
+    void WorkerLoop();
+    // fills the image from its KTX2 container; false leaves it to the stb_image path
+    static bool LoadBaked(Decoded& image);
+    // copies up to budget bytes into the upload's buffer; true when all of it is staged
+    bool Stage(Upload& upload, size_t& budget);
+    void Finish(Upload& upload);
+
+private:
+    size_t upload_budget_;
+    std::filesystem::path baked_directory_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Request> requests_;
+    std::deque<Decoded> decoded_;
+    bool stopping_;
+    // requested but not resident yet; only the render thread writes it
+    uint32_t in_flight_;
+    std::deque<Upload> uploads_;
+
+    uint32_t loaded_;
+    uint32_t failed_;
+    uint32_t compressed_;
+    double decode_ms_total_;
+    double decode_ms_max_;
+    uint64_t bytes_uploaded_;
+    uint32_t upload_frames_;
+    std::chrono::steady_clock::time_point first_request_;
+    double resident_ms_;
+};
@@ -0,0 +1,238 @@
+#include "trace.h"
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// events per thread; once full, further zones on that thread are counted and dropped
+static constexpr size_t THREAD_BUFFER_CAPACITY = 1 << 18;
+static constexpr uint32_t GPU_THREAD_ID = 0;
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct ThreadBuffer
+{
+    uint32_t thread_id = 0;
+    std::string name;
+    // CPU buffers hold Tracer::Now() ticks, the GPU buffer already holds nanoseconds since clock_origin
+    bool in_ticks = true;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct GpuZone
+{
+    const char* name;
+    uint32_t begin_query;
+    uint32_t end_query;
+    bool ended;
+};
+
+static std::atomic<bool> enabled{false};
+static const uint64_t tick_origin = Tracer::Now();
+static const std::chrono::steady_clock::time_point clock_origin = std::chrono::steady_clock::now();
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+static thread_local ThreadBuffer* local_buffer = nullptr;
+
+// GPU zones are only touched from the thread that owns the GL context
+static int64_t gpu_clock_offset_ns = 0;
+static std::deque<GpuZone> gpu_zones;
+static uint32_t gpu_zone_base = 0;
+static std::vector<uint32_t> free_queries;
+static ThreadBuffer gpu_buffer;
+
+static ThreadBuffer& get_thread_buffer()
+{
+    if (!local_buffer) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events = std::make_unique<TraceEvent[]>(THREAD_BUFFER_CAPACITY);
+        std::lock_guard<std::mutex> lock{registry_mutex};
+        buffer->thread_id = static_cast<uint32_t>(thread_buffers.size() + 1);
+        buffer->name = buffer->thread_id == 1 ? "main" : "thread " + std::to_string(buffer->thread_id);
+        local_buffer = buffer.get();
+        thread_buffers.push_back(std::move(buffer));
+    }
+    return *local_buffer;
+}
+
+static uint64_t steady_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clock_origin).count());
+}
+
+static void append_event(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end)
+{
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= THREAD_BUFFER_CAPACITY) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[index] = TraceEvent{name, start, end};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::Enable()
+{
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+bool Tracer::IsEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::Record(const char* name, uint64_t start, uint64_t end)
+{
+    append_event(get_thread_buffer(), name, start, end);
+}
+
+void Tracer::SetThreadName(const char* name)
+{
+    // naming a thread would allocate its event buffer, which only a recording thread needs
+    if (!IsEnabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = get_thread_buffer();
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    buffer.name = name;
+}
+
+void Tracer::CalibrateGpuClock()
+{
+    if (!IsEnabled()) {
+        return;
+    }
+    // GL_TIMESTAMP via glGetInteger64v is the GPU clock "now", once all previous commands are flushed
+    glFinish();
+    int64_t gpu_ns = 0;
+    uint64_t cpu_before = steady_ns();
+    glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+    uint64_t cpu_after = steady_ns();
+    gpu_clock_offset_ns = static_cast<int64_t>((cpu_before + cpu_after) / 2) - gpu_ns;
+    if (!gpu_buffer.events) {
+        gpu_buffer.events = std::make_unique<TraceEvent[]>(THREAD_BUFFER_CAPACITY);
+        gpu_buffer.thread_id = GPU_THREAD_ID;
+        gpu_buffer.name = "GPU";
+        gpu_buffer.in_ticks = false;
+    }
+}
+
+uint32_t Tracer::BeginGpuZone(const char* name)
+{
+    if (!gpu_buffer.events) {
+        return UINT32_MAX;
+    }
+    uint32_t queries[2] = {};
+    for (uint32_t& query : queries) {
+        if (free_queries.empty()) {
+            glGenQueries(1, &query);
+        } else {
+            query = free_queries.back();
+            free_queries.pop_back();
+        }
+    }
+    glQueryCounter(queries[0], GL_TIMESTAMP);
+    gpu_zones.push_back(GpuZone{name, queries[0], queries[1], false});
+    return gpu_zone_base + static_cast<uint32_t>(gpu_zones.size() - 1);
+}
+
+void Tracer::EndGpuZone(uint32_t zone)
+{
+    GpuZone& gpu_zone = gpu_zones[zone - gpu_zone_base];
+    glQueryCounter(gpu_zone.end_query, GL_TIMESTAMP);
+    gpu_zone.ended = true;
+}
+
+void Tracer::CollectGpuZones(bool wait)
+{
+    // zones end in submission order, so stop at the first one that isn't finished yet
+    while (!gpu_zones.empty()) {
+        GpuZone& zone = gpu_zones.front();
+        if (!zone.ended) {
+            break;
+        }
+        int32_t available = 0;
+        glGetQueryObjectiv(zone.end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !wait) {
+            break;
+        }
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        glGetQueryObjectui64v(zone.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.end_query, GL_QUERY_RESULT, &end);
+        append_event(gpu_buffer, zone.name, static_cast<uint64_t>(static_cast<int64_t>(begin) + gpu_clock_offset_ns),
+            static_cast<uint64_t>(static_cast<int64_t>(end) + gpu_clock_offset_ns));
+        free_queries.push_back(zone.begin_query);
+        free_queries.push_back(zone.end_query);
+        gpu_zones.pop_front();
+        ++gpu_zone_base;
+    }
+}
+
+static void write_events(std::ofstream& file, const ThreadBuffer& buffer, double ns_per_tick, bool& first)
+{
+    file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.thread_id
+        << ",\"args\":{\"name\":\"" << buffer.name << "\"}}";
+    first = false;
+    size_t count = buffer.count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const TraceEvent& event = buffer.events[i];
+        double start_ns = static_cast<double>(event.start);
+        double end_ns = static_cast<double>(event.end);
+        if (buffer.in_ticks) {
+            start_ns = (static_cast<double>(event.start) - static_cast<double>(tick_origin)) * ns_per_tick;
+            end_ns = (static_cast<double>(event.end) - static_cast<double>(tick_origin)) * ns_per_tick;
+        }
+        file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.thread_id
+            << ",\"ts\":" << start_ns / 1000.0 << ",\"dur\":" << (end_ns - start_ns) / 1000.0 << "}";
+    }
+    uint64_t dropped = buffer.dropped.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        std::cout << "Trace buffer of " << buffer.name << " overflowed, " << dropped << " zones dropped" << std::endl;
+    }
+}
+
+bool Tracer::WriteChromeTrace(const std::filesystem::path& file_path)
+{
+    std::ofstream file{file_path};
+    if (!file) {
+        std::cout << "Failed to write " << file_path.string() << std::endl;
+        return false;
+    }
+    // both clocks have been running since startup, which gives a precise tick rate
+    uint64_t elapsed_ns = steady_ns();
+    uint64_t elapsed_ticks = Now() - tick_origin;
+    double ns_per_tick = elapsed_ticks ? static_cast<double>(elapsed_ns) / static_cast<double>(elapsed_ticks) : 1.0;
+
+    file.precision(3);
+    file << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock{registry_mutex};
+        for (const std::unique_ptr<ThreadBuffer>& buffer : thread_buffers) {
+            write_events(file, *buffer, ns_per_tick, first);
+        }
+    }
+    if (gpu_buffer.events) {
+        write_events(file, gpu_buffer, ns_per_tick, first);
+    }
+    file << "\n]}\n";
+    std::cout << "Trace written to " << file_path.string() << std::endl;
+    return true;
+}
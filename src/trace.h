@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <filesystem>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_HAS_RDTSC 1
+#endif
+
+// Lightweight timeline tracing exported as Chrome trace-event JSON (open it in Perfetto or
+// about:tracing). CPU zones are recorded into a per-thread buffer that only its owning thread
+// writes, so recording is two clock reads and a store with no locks. On x86 the clock is the TSC,
+// converted to nanoseconds against steady_clock only when the trace is written. GPU zones use GL_TIMESTAMP
+// queries that are collected frames later and shifted onto the CPU clock.
+//
+// Zone names must be string literals (or otherwise outlive the tracer); they are stored by pointer.
+class Tracer
+{
+public:
+    static void Enable();
+    static bool IsEnabled();
+    // raw clock ticks, only meaningful to Record
+    static uint64_t Now()
+    {
+#if defined(TRACE_HAS_RDTSC)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+    static void Record(const char* name, uint64_t start, uint64_t end);
+    // no-op while tracing is disabled, so enable before starting the threads that should be named
+    static void SetThreadName(const char* name);
+
+    // needs a current GL context; pairs a GPU timestamp with the CPU clock
+    static void CalibrateGpuClock();
+    static uint32_t BeginGpuZone(const char* name);
+    static void EndGpuZone(uint32_t zone);
+    // converts finished GPU zones into events; with wait set it blocks until all are done
+    static void CollectGpuZones(bool wait);
+
+    static bool WriteChromeTrace(const std::filesystem::path& file_path);
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+        : name_(Tracer::IsEnabled() ? name : nullptr), start_(name_ ? Tracer::Now() : 0)
+    {
+
+    }
+
+    ~TraceScope()
+    {
+        if (name_) {
+            Tracer::Record(name_, start_, Tracer::Now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+class GpuTraceScope
+{
+public:
+    explicit GpuTraceScope(const char* name)
+        : zone_(Tracer::IsEnabled() ? Tracer::BeginGpuZone(name) : UINT32_MAX)
+    {
+
+    }
+
+    ~GpuTraceScope()
+    {
+        if (zone_ != UINT32_MAX) {
+            Tracer::EndGpuZone(zone_);
+        }
+    }
+
+    GpuTraceScope(const GpuTraceScope&) = delete;
+    GpuTraceScope& operator=(const GpuTraceScope&) = delete;
+
+private:
+    uint32_t zone_;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__){name}
+#define TRACE_GPU_SCOPE(name) GpuTraceScope TRACE_CONCAT(gpu_trace_scope_, __LINE__){name}
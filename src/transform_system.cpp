@@ -0,0 +1,306 @@
+#include "transform_system.h"
+#include "cpu_features.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#endif
+
+static constexpr size_t MATRIX_FLOATS = 16;
+
+// with indices the i-th output matrix belongs to object indices[i], otherwise to object i
+static void compose_scalar(const TransformStreams& streams, const uint32_t* indices, size_t begin, size_t end, float* out)
+{
+    for (size_t i = begin; i < end; ++i) {
+        size_t object = indices ? indices[i] : i;
+        float x = streams.rotation[0][object];
+        float y = streams.rotation[1][object];
+        float z = streams.rotation[2][object];
+        float w = streams.rotation[3][object];
+        float sx = streams.scale[0][object];
+        float sy = streams.scale[1][object];
+        float sz = streams.scale[2][object];
+        float* m = out + i * MATRIX_FLOATS;
+
+        m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        m[1] = 2.0f * (x * y + w * z) * sx;
+        m[2] = 2.0f * (x * z - w * y) * sx;
+        m[3] = 0.0f;
+        m[4] = 2.0f * (x * y - w * z) * sy;
+        m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        m[6] = 2.0f * (y * z + w * x) * sy;
+        m[7] = 0.0f;
+        m[8] = 2.0f * (x * z + w * y) * sz;
+        m[9] = 2.0f * (y * z - w * x) * sz;
+        m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        m[11] = 0.0f;
+        m[12] = streams.position[0][object];
+        m[13] = streams.position[1][object];
+        m[14] = streams.position[2][object];
+        m[15] = 1.0f;
+    }
+}
+
+#if defined(SIMD_X86)
+// lanes hold one matrix column for 4 objects each; transpose to 4 columns and scatter them
+static inline void store_column_sse(float* out, size_t column, __m128 a, __m128 b, __m128 c, __m128 d)
+{
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(out + 0 * MATRIX_FLOATS + column * 4, a);
+    _mm_storeu_ps(out + 1 * MATRIX_FLOATS + column * 4, b);
+    _mm_storeu_ps(out + 2 * MATRIX_FLOATS + column * 4, c);
+    _mm_storeu_ps(out + 3 * MATRIX_FLOATS + column * 4, d);
+}
+
+template<bool Indexed>
+static inline __m128 load_sse(const float* stream, const uint32_t* indices, size_t i)
+{
+    if constexpr (Indexed) {
+        return _mm_set_ps(stream[indices[i + 3]], stream[indices[i + 2]], stream[indices[i + 1]], stream[indices[i]]);
+    } else {
+        return _mm_load_ps(stream + i);
+    }
+}
+
+template<bool Indexed>
+static size_t compose_sse(const TransformStreams& streams, const uint32_t* indices, size_t count, float* out)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t batched = count & ~size_t{3};
+    for (size_t i = 0; i < batched; i += 4) {
+        __m128 x = load_sse<Indexed>(streams.rotation[0], indices, i);
+        __m128 y = load_sse<Indexed>(streams.rotation[1], indices, i);
+        __m128 z = load_sse<Indexed>(streams.rotation[2], indices, i);
+        __m128 w = load_sse<Indexed>(streams.rotation[3], indices, i);
+        __m128 sx = load_sse<Indexed>(streams.scale[0], indices, i);
+        __m128 sy = load_sse<Indexed>(streams.scale[1], indices, i);
+        __m128 sz = load_sse<Indexed>(streams.scale[2], indices, i);
+
+        __m128 xx = _mm_mul_ps(x, x);
+        __m128 yy = _mm_mul_ps(y, y);
+        __m128 zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y);
+        __m128 xz = _mm_mul_ps(x, z);
+        __m128 yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x);
+        __m128 wy = _mm_mul_ps(w, y);
+        __m128 wz = _mm_mul_ps(w, z);
+
+        float* m = out + i * MATRIX_FLOATS;
+        store_column_sse(m, 0,
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+            zero);
+        store_column_sse(m, 1,
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+            zero);
+        store_column_sse(m, 2,
+            _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+            _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+            zero);
+        store_column_sse(m, 3,
+            load_sse<Indexed>(streams.position[0], indices, i),
+            load_sse<Indexed>(streams.position[1], indices, i),
+            load_sse<Indexed>(streams.position[2], indices, i),
+            one);
+    }
+    return batched;
+}
+
+// same as the SSE version, but each 128-bit half of the transposed registers belongs to
+// object k and k + 4
+SIMD_TARGET_AVX2 static inline void store_column_avx2(float* out, size_t column, __m256 a, __m256 b, __m256 c, __m256 d)
+{
+    __m256 t0 = _mm256_unpacklo_ps(a, b);
+    __m256 t1 = _mm256_unpackhi_ps(a, b);
+    __m256 t2 = _mm256_unpacklo_ps(c, d);
+    __m256 t3 = _mm256_unpackhi_ps(c, d);
+    __m256 v0 = _mm256_shuffle_ps(t0, t2, 0x44);
+    __m256 v1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+    __m256 v2 = _mm256_shuffle_ps(t1, t3, 0x44);
+    __m256 v3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+    out += column * 4;
+    _mm_storeu_ps(out + 0 * MATRIX_FLOATS, _mm256_castps256_ps128(v0));
+    _mm_storeu_ps(out + 1 * MATRIX_FLOATS, _mm256_castps256_ps128(v1));
+    _mm_storeu_ps(out + 2 * MATRIX_FLOATS, _mm256_castps256_ps128(v2));
+    _mm_storeu_ps(out + 3 * MATRIX_FLOATS, _mm256_castps256_ps128(v3));
+    _mm_storeu_ps(out + 4 * MATRIX_FLOATS, _mm256_extractf128_ps(v0, 1));
+    _mm_storeu_ps(out + 5 * MATRIX_FLOATS, _mm256_extractf128_ps(v1, 1));
+    _mm_storeu_ps(out + 6 * MATRIX_FLOATS, _mm256_extractf128_ps(v2, 1));
+    _mm_storeu_ps(out + 7 * MATRIX_FLOATS, _mm256_extractf128_ps(v3, 1));
+}
+
+template<bool Indexed>
+SIMD_TARGET_AVX2 static inline __m256 load_avx2(const float* stream, const uint32_t* indices, size_t i)
+{
+    if constexpr (Indexed) {
+        __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        return _mm256_i32gather_ps(stream, offsets, 4);
+    } else {
+        return _mm256_load_ps(stream + i);
+    }
+}
+
+template<bool Indexed>
+SIMD_TARGET_AVX2 static size_t compose_avx2(const TransformStreams& streams, const uint32_t* indices, size_t count, float* out)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t batched = count & ~size_t{7};
+    for (size_t i = 0; i < batched; i += 8) {
+        __m256 x = load_avx2<Indexed>(streams.rotation[0], indices, i);
+        __m256 y = load_avx2<Indexed>(streams.rotation[1], indices, i);
+        __m256 z = load_avx2<Indexed>(streams.rotation[2], indices, i);
+        __m256 w = load_avx2<Indexed>(streams.rotation[3], indices, i);
+        __m256 sx = load_avx2<Indexed>(streams.scale[0], indices, i);
+        __m256 sy = load_avx2<Indexed>(streams.scale[1], indices, i);
+        __m256 sz = load_avx2<Indexed>(streams.scale[2], indices, i);
+
+        __m256 xx = _mm256_mul_ps(x, x);
+        __m256 yy = _mm256_mul_ps(y, y);
+        __m256 zz = _mm256_mul_ps(z, z);
+        __m256 xy = _mm256_mul_ps(x, y);
+        __m256 xz = _mm256_mul_ps(x, z);
+        __m256 yz = _mm256_mul_ps(y, z);
+        __m256 wx = _mm256_mul_ps(w, x);
+        __m256 wy = _mm256_mul_ps(w, y);
+        __m256 wz = _mm256_mul_ps(w, z);
+
+        float* m = out + i * MATRIX_FLOATS;
+        store_column_avx2(m, 0,
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+            zero);
+        store_column_avx2(m, 1,
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+            zero);
+        store_column_avx2(m, 2,
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz),
+            zero);
+        store_column_avx2(m, 3,
+            load_avx2<Indexed>(streams.position[0], indices, i),
+            load_avx2<Indexed>(streams.position[1], indices, i),
+            load_avx2<Indexed>(streams.position[2], indices, i),
+            one);
+    }
+    return batched;
+}
+#endif
+
+uint32_t TransformSystem::Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    position_x_.push_back(position.x);
+    position_y_.push_back(position.y);
+    position_z_.push_back(position.z);
+    rotation_x_.push_back(rotation.x);
+    rotation_y_.push_back(rotation.y);
+    rotation_z_.push_back(rotation.z);
+    rotation_w_.push_back(rotation.w);
+    scale_x_.push_back(scale.x);
+    scale_y_.push_back(scale.y);
+    scale_z_.push_back(scale.z);
+    return static_cast<uint32_t>(position_x_.size() - 1);
+}
+
+void TransformSystem::Reserve(size_t count)
+{
+    for (AlignedFloats* stream : {&position_x_, &position_y_, &position_z_, &rotation_x_, &rotation_y_, &rotation_z_,
+             &rotation_w_, &scale_x_, &scale_y_, &scale_z_}) {
+        stream->reserve(count);
+    }
+}
+
+void TransformSystem::Clear()
+{
+    for (AlignedFloats* stream : {&position_x_, &position_y_, &position_z_, &rotation_x_, &rotation_y_, &rotation_z_,
+             &rotation_w_, &scale_x_, &scale_y_, &scale_z_}) {
+        stream->clear();
+    }
+}
+
+size_t TransformSystem::Size() const
+{
+    return position_x_.size();
+}
+
+glm::vec3 TransformSystem::GetPosition(uint32_t index) const
+{
+    return glm::vec3{position_x_[index], position_y_[index], position_z_[index]};
+}
+
+void TransformSystem::SetPosition(uint32_t index, const glm::vec3& position)
+{
+    position_x_[index] = position.x;
+    position_y_[index] = position.y;
+    position_z_[index] = position.z;
+}
+
+void TransformSystem::SetRotation(uint32_t index, const glm::quat& rotation)
+{
+    rotation_x_[index] = rotation.x;
+    rotation_y_[index] = rotation.y;
+    rotation_z_[index] = rotation.z;
+    rotation_w_[index] = rotation.w;
+}
+
+void TransformSystem::SetScale(uint32_t index, const glm::vec3& scale)
+{
+    scale_x_[index] = scale.x;
+    scale_y_[index] = scale.y;
+    scale_z_[index] = scale.z;
+}
+
+void TransformSystem::ComposeMatrices(glm::mat4* out) const
+{
+    TransformStreams streams = GetStreams();
+    float* dst = reinterpret_cast<float*>(out);
+    size_t done = 0;
+#if defined(SIMD_X86)
+    if (GetCPUFeatures().avx2 && GetCPUFeatures().fma) {
+        done = compose_avx2<false>(streams, nullptr, streams.count, dst);
+    } else {
+        done = compose_sse<false>(streams, nullptr, streams.count, dst);
+    }
+#endif
+    compose_scalar(streams, nullptr, done, streams.count, dst);
+}
+
+void TransformSystem::ComposeMatrices(const uint32_t* indices, size_t count, glm::mat4* out) const
+{
+    TransformStreams streams = GetStreams();
+    float* dst = reinterpret_cast<float*>(out);
+    size_t done = 0;
+#if defined(SIMD_X86)
+    if (GetCPUFeatures().avx2 && GetCPUFeatures().fma) {
+        done = compose_avx2<true>(streams, indices, count, dst);
+    } else {
+        done = compose_sse<true>(streams, indices, count, dst);
+    }
+#endif
+    compose_scalar(streams, indices, done, count, dst);
+}
+
+void TransformSystem::ComposeMatricesScalar(glm::mat4* out) const
+{
+    compose_scalar(GetStreams(), nullptr, 0, Size(), reinterpret_cast<float*>(out));
+}
+
+TransformStreams TransformSystem::GetStreams() const
+{
+    return TransformStreams{
+        {position_x_.data(), position_y_.data(), position_z_.data()},
+        {rotation_x_.data(), rotation_y_.data(), rotation_z_.data(), rotation_w_.data()},
+        {scale_x_.data(), scale_y_.data(), scale_z_.data()},
+        Size()};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "aligned_allocator.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float, 32>>;
+
+// read-only view over the component arrays handed to the SIMD kernels
+struct TransformStreams
+{
+    const float* position[3];
+    const float* rotation[4];
+    const float* scale[3];
+    size_t count;
+};
+
+// Positions, rotations and scales stored component by component (SoA), so model matrices
+// can be composed 8 (AVX2) or 4 (SSE) objects at a time. ComposeMatrices writes T * R * S
+// column-major, the same layout glm::mat4 and the instance attributes use, so the output can
+// point straight at a mapped upload buffer.
+class TransformSystem
+{
+public:
+    uint32_t Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void Reserve(size_t count);
+    void Clear();
+    size_t Size() const;
+
+    glm::vec3 GetPosition(uint32_t index) const;
+    void SetPosition(uint32_t index, const glm::vec3& position);
+    void SetRotation(uint32_t index, const glm::quat& rotation);
+    void SetScale(uint32_t index, const glm::vec3& scale);
+
+    // out needs room for Size() matrices; it does not have to be aligned
+    void ComposeMatrices(glm::mat4* out) const;
+    // composes only the listed objects, packed densely into out (e.g. the survivors of culling)
+    void ComposeMatrices(const uint32_t* indices, size_t count, glm::mat4* out) const;
+    void ComposeMatricesScalar(glm::mat4* out) const;
+    TransformStreams GetStreams() const;
+
+private:
+    AlignedFloats position_x_;
+    AlignedFloats position_y_;
+    AlignedFloats position_z_;
+    AlignedFloats rotation_x_;
+    AlignedFloats rotation_y_;
+    AlignedFloats rotation_z_;
+    AlignedFloats rotation_w_;
+    AlignedFloats scale_x_;
+    AlignedFloats scale_y_;
+    AlignedFloats scale_z_;
+};
@@ -0,0 +1,571 @@
+#include "bc_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr int32_t BLOCK_PIXELS = 16;
+
+// BC7 interpolation weights for 4 bit indices, out of 64
+static const int32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static void load_block(const uint8_t* rgba, float pixels[BLOCK_PIXELS][4])
+{
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        for (int32_t c = 0; c < 4; ++c) {
+            pixels[i][c] = static_cast<float>(rgba[i * 4 + c]);
+        }
+    }
+}
+
+// Endpoints of the line through the block's mean along its principal axis, trimmed to the
+// outermost projected pixels. Only the first `channels` channels take part.
+static void fit_endpoints(const float pixels[BLOCK_PIXELS][4], int32_t channels, float lo[4], float hi[4])
+{
+    float mean[4] = {};
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        for (int32_t c = 0; c < channels; ++c) {
+            mean[c] += pixels[i][c] / BLOCK_PIXELS;
+        }
+    }
+    float covariance[4][4] = {};
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        for (int32_t a = 0; a < channels; ++a) {
+            for (int32_t b = 0; b < channels; ++b) {
+                covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // power iteration from the channel with the widest spread converges in a few steps for 4x4
+    int32_t widest = 0;
+    for (int32_t c = 1; c < channels; ++c) {
+        widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+    }
+    float axis[4] = {};
+    axis[widest] = covariance[widest][widest] > 0.0f ? 1.0f : 0.0f;
+    for (int32_t iteration = 0; iteration < 8 && axis[widest] != 0.0f; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int32_t a = 0; a < channels; ++a) {
+            for (int32_t b = 0; b < channels; ++b) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length += next[a] * next[a];
+        }
+        length = std::sqrt(length);
+        for (int32_t c = 0; c < channels; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float t_min = 0.0f;
+    float t_max = 0.0f;
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        float t = 0.0f;
+        for (int32_t c = 0; c < channels; ++c) {
+            t += (pixels[i][c] - mean[c]) * axis[c];
+        }
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+    for (int32_t c = 0; c < channels; ++c) {
+        lo[c] = std::clamp(mean[c] + t_min * axis[c], 0.0f, 255.0f);
+        hi[c] = std::clamp(mean[c] + t_max * axis[c], 0.0f, 255.0f);
+    }
+}
+
+// Least squares endpoints for fixed interpolation weights: minimizes the summed squared error
+// of (1 - w) * a + w * b against the pixels. False when every pixel uses the same weight.
+static bool solve_endpoints(const float pixels[BLOCK_PIXELS][4], const float weights[BLOCK_PIXELS], int32_t channels,
+    float a[4], float b[4])
+{
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        float w = weights[i];
+        aa += (1.0f - w) * (1.0f - w);
+        ab += (1.0f - w) * w;
+        bb += w * w;
+        for (int32_t c = 0; c < channels; ++c) {
+            ax[c] += (1.0f - w) * pixels[i][c];
+            bx[c] += w * pixels[i][c];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (int32_t c = 0; c < channels; ++c) {
+        a[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+        b[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+static uint32_t squared_error(const uint8_t* pixel, const int32_t* color, int32_t channels)
+{
+    uint32_t error = 0;
+    for (int32_t c = 0; c < channels; ++c) {
+        int32_t d = static_cast<int32_t>(pixel[c]) - color[c];
+        error += static_cast<uint32_t>(d * d);
+    }
+    return error;
+}
+
+// ---------------------------------------------------------------------------------------------
+// BC1 color
+
+static uint16_t pack_565(const float color[4])
+{
+    uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+    uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+    uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t packed, int32_t color[3])
+{
+    int32_t r = packed >> 11;
+    int32_t g = (packed >> 5) & 63;
+    int32_t b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// four-color palette, valid when c0 > c1
+static void bc1_palette(uint16_t c0, uint16_t c1, int32_t palette[4][3])
+{
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int32_t c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+}
+
+// nearest palette entry per pixel; returns the block's squared error
+static uint32_t bc1_indices(const uint8_t* rgba, uint16_t c0, uint16_t c1, uint8_t indices[BLOCK_PIXELS])
+{
+    int32_t palette[4][3];
+    bc1_palette(c0, c1, palette);
+    // equal endpoints would decode in three-color mode, where index 3 is black
+    int32_t entries = c0 == c1 ? 1 : 4;
+    uint32_t total = 0;
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        uint32_t best = UINT32_MAX;
+        for (int32_t entry = 0; entry < entries; ++entry) {
+            uint32_t error = squared_error(rgba + i * 4, palette[entry], 3);
+            if (error < best) {
+                best = error;
+                indices[i] = static_cast<uint8_t>(entry);
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+static void encode_color_block(const uint8_t* rgba, uint8_t* out)
+{
+    static const float index_weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+    float pixels[BLOCK_PIXELS][4];
+    load_block(rgba, pixels);
+    float lo[4];
+    float hi[4];
+    fit_endpoints(pixels, 3, lo, hi);
+
+    uint16_t best_c0 = std::max(pack_565(hi), pack_565(lo));
+    uint16_t best_c1 = std::min(pack_565(hi), pack_565(lo));
+    uint8_t best_indices[BLOCK_PIXELS];
+    uint32_t best_error = bc1_indices(rgba, best_c0, best_c1, best_indices);
+
+    // refit the endpoints to the chosen indices while that keeps lowering the error
+    for (int32_t iteration = 0; iteration < 2 && best_error > 0; ++iteration) {
+        float weights[BLOCK_PIXELS];
+        for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+            weights[i] = index_weights[best_indices[i]];
+        }
+        float a[4];
+        float b[4];
+        if (!solve_endpoints(pixels, weights, 3, a, b)) {
+            break;
+        }
+        uint16_t c0 = std::max(pack_565(a), pack_565(b));
+        uint16_t c1 = std::min(pack_565(a), pack_565(b));
+        uint8_t indices[BLOCK_PIXELS];
+        uint32_t error = bc1_indices(rgba, c0, c1, indices);
+        if (error >= best_error) {
+            break;
+        }
+        best_c0 = c0;
+        best_c1 = c1;
+        best_error = error;
+        std::memcpy(best_indices, indices, sizeof(indices));
+    }
+
+    uint32_t bits = 0;
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        bits |= static_cast<uint32_t>(best_indices[i]) << (2 * i);
+    }
+    std::memcpy(out, &best_c0, 2);
+    std::memcpy(out + 2, &best_c1, 2);
+    std::memcpy(out + 4, &bits, 4);
+}
+
+static void decode_color_block(const uint8_t* block, bool four_color, uint8_t* rgba)
+{
+    uint16_t c0;
+    uint16_t c1;
+    uint32_t bits;
+    std::memcpy(&c0, block, 2);
+    std::memcpy(&c1, block + 2, 2);
+    std::memcpy(&bits, block + 4, 4);
+    int32_t palette[4][3];
+    bc1_palette(c0, c1, palette);
+    bool three_color = !four_color && c0 <= c1;
+    if (three_color) {
+        for (int32_t c = 0; c < 3; ++c) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        uint32_t index = (bits >> (2 * i)) & 3;
+        for (int32_t c = 0; c < 3; ++c) {
+            rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+        }
+        rgba[i * 4 + 3] = three_color && index == 3 ? 0 : 255;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// BC3 alpha
+
+static void alpha_palette(int32_t a0, int32_t a1, int32_t palette[8])
+{
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int32_t i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+    } else {
+        for (int32_t i = 2; i < 6; ++i) {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static void encode_alpha_block(const uint8_t* rgba, uint8_t* out)
+{
+    int32_t lo = 255;
+    int32_t hi = 0;
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        lo = std::min<int32_t>(lo, rgba[i * 4 + 3]);
+        hi = std::max<int32_t>(hi, rgba[i * 4 + 3]);
+    }
+    // eight-value mode spans the block's range; a constant block only needs index 0
+    uint64_t bits = 0;
+    if (hi > lo) {
+        int32_t palette[8];
+        alpha_palette(hi, lo, palette);
+        for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+            int32_t alpha = rgba[i * 4 + 3];
+            int32_t best = 0;
+            for (int32_t entry = 1; entry < 8; ++entry) {
+                best = std::abs(palette[entry] - alpha) < std::abs(palette[best] - alpha) ? entry : best;
+            }
+            bits |= static_cast<uint64_t>(best) << (3 * i);
+        }
+    }
+    out[0] = static_cast<uint8_t>(hi);
+    out[1] = static_cast<uint8_t>(lo);
+    for (int32_t i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+}
+
+static void decode_alpha_block(const uint8_t* block, uint8_t* rgba)
+{
+    int32_t palette[8];
+    alpha_palette(block[0], block[1], palette);
+    uint64_t bits = 0;
+    for (int32_t i = 0; i < 6; ++i) {
+        bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        rgba[i * 4 + 3] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// BC7 mode 6
+
+struct Bc7Endpoints
+{
+    // 7 bit values and p-bits; the 8 bit endpoint is (value << 1) | p-bit
+    uint8_t value[2][4];
+    uint8_t pbit[2];
+};
+
+static void bc7_expand(const Bc7Endpoints& endpoints, int32_t colors[2][4])
+{
+    for (int32_t e = 0; e < 2; ++e) {
+        for (int32_t c = 0; c < 4; ++c) {
+            colors[e][c] = (endpoints.value[e][c] << 1) | endpoints.pbit[e];
+        }
+    }
+}
+
+static uint32_t bc7_indices(const uint8_t* rgba, const Bc7Endpoints& endpoints, uint8_t indices[BLOCK_PIXELS])
+{
+    int32_t colors[2][4];
+    bc7_expand(endpoints, colors);
+    int32_t palette[16][4];
+    for (int32_t entry = 0; entry < 16; ++entry) {
+        int32_t w = BC7_WEIGHTS[entry];
+        for (int32_t c = 0; c < 4; ++c) {
+            palette[entry][c] = ((64 - w) * colors[0][c] + w * colors[1][c] + 32) >> 6;
+        }
+    }
+    uint32_t total = 0;
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        uint32_t best = UINT32_MAX;
+        for (int32_t entry = 0; entry < 16; ++entry) {
+            uint32_t error = squared_error(rgba + i * 4, palette[entry], 4);
+            if (error < best) {
+                best = error;
+                indices[i] = static_cast<uint8_t>(entry);
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+// tries all four p-bit combinations for the float endpoints, keeping the best in `best`
+static void bc7_quantize(const uint8_t* rgba, const float a[4], const float b[4], Bc7Endpoints& best,
+    uint8_t best_indices[BLOCK_PIXELS], uint32_t& best_error)
+{
+    for (uint8_t p0 = 0; p0 < 2; ++p0) {
+        for (uint8_t p1 = 0; p1 < 2; ++p1) {
+            Bc7Endpoints endpoints{};
+            endpoints.pbit[0] = p0;
+            endpoints.pbit[1] = p1;
+            for (int32_t c = 0; c < 4; ++c) {
+                endpoints.value[0][c] = static_cast<uint8_t>(std::clamp<long>(std::lround((a[c] - p0) / 2.0f), 0, 127));
+                endpoints.value[1][c] = static_cast<uint8_t>(std::clamp<long>(std::lround((b[c] - p1) / 2.0f), 0, 127));
+            }
+            uint8_t indices[BLOCK_PIXELS];
+            uint32_t error = bc7_indices(rgba, endpoints, indices);
+            if (error < best_error) {
+                best = endpoints;
+                best_error = error;
+                std::memcpy(best_indices, indices, sizeof(indices));
+            }
+        }
+    }
+}
+
+struct BitWriter
+{
+    uint8_t* out;
+    uint32_t position = 0;
+
+    void Put(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; ++i, ++position) {
+            out[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+        }
+    }
+};
+
+struct BitReader
+{
+    const uint8_t* in;
+    uint32_t position = 0;
+
+    uint32_t Get(uint32_t bits)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; ++i, ++position) {
+            value |= static_cast<uint32_t>((in[position >> 3] >> (position & 7)) & 1) << i;
+        }
+        return value;
+    }
+};
+
+void EncodeBC7Block(const uint8_t* rgba, uint8_t* out)
+{
+    float pixels[BLOCK_PIXELS][4];
+    load_block(rgba, pixels);
+    float lo[4];
+    float hi[4];
+    fit_endpoints(pixels, 4, lo, hi);
+
+    Bc7Endpoints best{};
+    uint8_t best_indices[BLOCK_PIXELS] = {};
+    uint32_t best_error = UINT32_MAX;
+    bc7_quantize(rgba, lo, hi, best, best_indices, best_error);
+    for (int32_t iteration = 0; iteration < 2 && best_error > 0; ++iteration) {
+        float weights[BLOCK_PIXELS];
+        for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+            weights[i] = static_cast<float>(BC7_WEIGHTS[best_indices[i]]) / 64.0f;
+        }
+        float a[4];
+        float b[4];
+        uint32_t previous = best_error;
+        if (!solve_endpoints(pixels, weights, 4, a, b)) {
+            break;
+        }
+        bc7_quantize(rgba, a, b, best, best_indices, best_error);
+        if (best_error == previous) {
+            break;
+        }
+    }
+
+    // the anchor (first) index is stored without its top bit, so it has to be below 8
+    if (best_indices[0] >= 8) {
+        std::swap(best.value[0], best.value[1]);
+        std::swap(best.pbit[0], best.pbit[1]);
+        for (uint8_t& index : best_indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer{out};
+    writer.Put(1 << 6, 7);
+    for (int32_t c = 0; c < 4; ++c) {
+        writer.Put(best.value[0][c], 7);
+        writer.Put(best.value[1][c], 7);
+    }
+    writer.Put(best.pbit[0], 1);
+    writer.Put(best.pbit[1], 1);
+    writer.Put(best_indices[0], 3);
+    for (int32_t i = 1; i < BLOCK_PIXELS; ++i) {
+        writer.Put(best_indices[i], 4);
+    }
+}
+
+static void decode_bc7_block(const uint8_t* block, uint8_t* rgba)
+{
+    BitReader reader{block};
+    if (reader.Get(7) != (1 << 6)) {
+        // not mode 6; magenta makes it stand out in error measurements
+        for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+            rgba[i * 4 + 0] = 255;
+            rgba[i * 4 + 1] = 0;
+            rgba[i * 4 + 2] = 255;
+            rgba[i * 4 + 3] = 255;
+        }
+        return;
+    }
+    Bc7Endpoints endpoints{};
+    for (int32_t c = 0; c < 4; ++c) {
+        endpoints.value[0][c] = static_cast<uint8_t>(reader.Get(7));
+        endpoints.value[1][c] = static_cast<uint8_t>(reader.Get(7));
+    }
+    endpoints.pbit[0] = static_cast<uint8_t>(reader.Get(1));
+    endpoints.pbit[1] = static_cast<uint8_t>(reader.Get(1));
+    int32_t colors[2][4];
+    bc7_expand(endpoints, colors);
+    for (int32_t i = 0; i < BLOCK_PIXELS; ++i) {
+        int32_t w = BC7_WEIGHTS[reader.Get(i == 0 ? 3 : 4)];
+        for (int32_t c = 0; c < 4; ++c) {
+            rgba[i * 4 + c] = static_cast<uint8_t>(((64 - w) * colors[0][c] + w * colors[1][c] + 32) >> 6);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+
+void EncodeBC1Block(const uint8_t* rgba, uint8_t* out)
+{
+    encode_color_block(rgba, out);
+}
+
+void EncodeBC3Block(const uint8_t* rgba, uint8_t* out)
+{
+    encode_alpha_block(rgba, out);
+    encode_color_block(rgba, out + 8);
+}
+
+void DecodeBlock(Ktx2Format format, const uint8_t* block, uint8_t* rgba)
+{
+    switch (format) {
+    case Ktx2Format::BC1_RGB_UNORM:
+    case Ktx2Format::BC1_RGB_SRGB:
+        decode_color_block(block, false, rgba);
+        break;
+    case Ktx2Format::BC3_UNORM:
+    case Ktx2Format::BC3_SRGB:
+        decode_color_block(block + 8, true, rgba);
+        decode_alpha_block(block, rgba);
+        break;
+    case Ktx2Format::BC7_UNORM:
+    case Ktx2Format::BC7_SRGB:
+        decode_bc7_block(block, rgba);
+        break;
+    default:
+        std::memset(rgba, 0, BLOCK_PIXELS * 4);
+        break;
+    }
+}
+
+std::vector<uint8_t> CompressImage(Ktx2Format format, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+    uint32_t block_bytes = Ktx2BlockBytes(format);
+    uint32_t blocks_x = (width + 3) / 4;
+    uint32_t blocks_y = (height + 3) / 4;
+    std::vector<uint8_t> blocks(Ktx2LevelSize(format, width, height));
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            uint8_t block[BLOCK_PIXELS * 4];
+            for (uint32_t y = 0; y < 4; ++y) {
+                uint32_t source_y = std::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; ++x) {
+                    uint32_t source_x = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(source_y) * width + source_x) * 4, 4);
+                }
+            }
+            uint8_t* out = blocks.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_bytes;
+            if (block_bytes == 8) {
+                EncodeBC1Block(block, out);
+            } else if (format == Ktx2Format::BC3_UNORM || format == Ktx2Format::BC3_SRGB) {
+                EncodeBC3Block(block, out);
+            } else {
+                EncodeBC7Block(block, out);
+            }
+        }
+    }
+    return blocks;
+}
+
+std::vector<uint8_t> DecompressImage(Ktx2Format format, const uint8_t* blocks, uint32_t width, uint32_t height)
+{
+    uint32_t block_bytes = Ktx2BlockBytes(format);
+    uint32_t blocks_x = (width + 3) / 4;
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    for (uint32_t by = 0; by < (height + 3) / 4; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            uint8_t block[BLOCK_PIXELS * 4];
+            DecodeBlock(format, blocks + (static_cast<size_t>(by) * blocks_x + bx) * block_bytes, block);
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    std::memcpy(rgba.data() + ((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4,
+                        block + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+    return rgba;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ktx2.h"
+
+#include <stdint.h>
+#include <vector>
+
+// CPU block compressors for the formats texbake writes. Every function works on one 4x4 block
+// of RGBA8 pixels in row-major order (64 bytes).
+//  - BC1: principal axis endpoints refined by least squares, always in four-color mode
+//  - BC3: the BC1 color block plus an eight-value alpha block between the block's min and max
+//  - BC7: mode 6 only (one RGBA subset, 7 bit endpoints with p-bits, 4 bit indices), which
+//    covers smooth color and alpha well without the partition search of a full encoder
+void EncodeBC1Block(const uint8_t* rgba, uint8_t* out);
+void EncodeBC3Block(const uint8_t* rgba, uint8_t* out);
+void EncodeBC7Block(const uint8_t* rgba, uint8_t* out);
+
+// Decodes a block written by the encoders above back to RGBA8, for measuring the error. The
+// BC7 decoder only understands mode 6.
+void DecodeBlock(Ktx2Format format, const uint8_t* block, uint8_t* rgba);
+
+// compresses a whole RGBA8 image; partial blocks on the right and bottom edge repeat the last
+// column and row
+std::vector<uint8_t> CompressImage(Ktx2Format format, const uint8_t* rgba, uint32_t width, uint32_t height);
+std::vector<uint8_t> DecompressImage(Ktx2Format format, const uint8_t* blocks, uint32_t width, uint32_t height);
@@ -0,0 +1,160 @@
+// Offline texture compressor: decodes an image with stb_image, builds its mip chain with
+// GenerateMipChain and writes every level block-compressed into a KTX2 container that
+// TextureLoader uploads as is.
+
+#include "bc_encoder.h"
+#include "ktx2.h"
+#include "mip_generator.h"
+
+#include <stb_image.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Options
+{
+    std::string format = "auto";
+    bool srgb = false;
+    bool flip_vertically = true;
+    MipOptions mips;
+    std::string input;
+    std::string output;
+};
+
+static void print_usage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--format auto|bc1|bc3|bc7] [--srgb] [--no-flip] [--mip-filter box|kaiser] [--linear]"
+              << " [--premultiply] <input image> <output.ktx2>" << std::endl;
+    std::cout << "  auto picks BC1 for opaque images and BC3 for images with alpha. Images are flipped to GL's" << std::endl;
+    std::cout << "  bottom-up row order unless --no-flip is given, matching TextureParams::flip_vertically." << std::endl;
+    std::cout << "  Mips are filtered in linear light unless --linear says the data isn't sRGB encoded color;" << std::endl;
+    std::cout << "  --premultiply weights color by alpha so transparent texels don't bleed into the lower levels." << std::endl;
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (arg == "--srgb") {
+            options.srgb = true;
+        } else if (arg == "--no-flip") {
+            options.flip_vertically = false;
+        } else if (arg == "--mip-filter" && i + 1 < argc) {
+            std::string filter = argv[++i];
+            if (filter != "box" && filter != "kaiser") {
+                return false;
+            }
+            options.mips.filter = filter == "box" ? MipFilter::BOX : MipFilter::KAISER;
+        } else if (arg == "--linear") {
+            options.mips.srgb = false;
+        } else if (arg == "--premultiply") {
+            options.mips.premultiply_alpha = true;
+        } else if (!arg.starts_with("--")) {
+            files.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+    // an sRGB format is decoded to linear by the sampler, so its texels are sRGB encoded by definition
+    if (files.size() != 2 || (options.srgb && !options.mips.srgb)) {
+        return false;
+    }
+    options.input = files[0];
+    options.output = files[1];
+    return options.format == "auto" || options.format == "bc1" || options.format == "bc3" || options.format == "bc7";
+}
+
+static Ktx2Format pick_format(const std::string& name, bool srgb, bool has_alpha)
+{
+    if (name == "bc7") {
+        return srgb ? Ktx2Format::BC7_SRGB : Ktx2Format::BC7_UNORM;
+    }
+    if (name == "bc3" || (name == "auto" && has_alpha)) {
+        return srgb ? Ktx2Format::BC3_SRGB : Ktx2Format::BC3_UNORM;
+    }
+    return srgb ? Ktx2Format::BC1_RGB_SRGB : Ktx2Format::BC1_RGB_UNORM;
+}
+
+static double psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t channels)
+{
+    double error = 0.0;
+    size_t samples = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            double d = static_cast<double>(a[i + c]) - static_cast<double>(b[i + c]);
+            error += d * d;
+            ++samples;
+        }
+    }
+    double mse = error / static_cast<double>(samples);
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    stbi_set_flip_vertically_on_load(options.flip_vertically);
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t channels = 0;
+    uint8_t* pixels = stbi_load(options.input.c_str(), &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cout << "Failed to load image " << options.input << ": " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> image(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+
+    bool has_alpha = false;
+    for (size_t i = 3; i < image.size() && !has_alpha; i += 4) {
+        has_alpha = image[i] < 255;
+    }
+    Ktx2Texture texture;
+    texture.format = pick_format(options.format, options.srgb, has_alpha);
+    texture.width = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+    texture.orientation = options.flip_vertically ? "ru" : "rd";
+
+    auto mip_start = std::chrono::steady_clock::now();
+    std::vector<MipLevel> levels = GenerateMipChain(image.data(), texture.width, texture.height, options.mips);
+    double mip_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mip_start).count();
+    levels.insert(levels.begin(), MipLevel{texture.width, texture.height, std::move(image)});
+
+    double quality = 0.0;
+    size_t uncompressed = 0;
+    for (const MipLevel& level : levels) {
+        std::vector<uint8_t> blocks = CompressImage(texture.format, level.rgba.data(), level.width, level.height);
+        if (texture.levels.empty()) {
+            std::vector<uint8_t> decoded = DecompressImage(texture.format, blocks.data(), level.width, level.height);
+            quality = psnr(level.rgba, decoded, Ktx2BlockBytes(texture.format) == 8 ? 3 : 4);
+        }
+        texture.levels.push_back(Ktx2Level{texture.data.size(), blocks.size()});
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+        uncompressed += static_cast<size_t>(level.width) * level.height * static_cast<uint32_t>(channels);
+    }
+
+    if (!WriteKtx2(options.output, texture)) {
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << options.input << ": " << width << "x" << height << " " << Ktx2FormatName(texture.format) << ", "
+              << texture.levels.size() << " levels, " << static_cast<double>(texture.data.size()) / 1024.0 << " KiB ("
+              << static_cast<double>(uncompressed) / static_cast<double>(texture.data.size()) << "x smaller than "
+              << channels << " byte texels), PSNR " << quality << " dB, " << ms << " ms (" << mip_ms << " ms of it "
+              << (options.mips.filter == MipFilter::BOX ? "box" : "Kaiser") << " filtering)" << std::endl;
+    return 0;
+}